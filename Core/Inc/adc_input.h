@@ -0,0 +1,46 @@
+/*
+ * adc_input.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_ADC_INPUT_H_
+#define INC_ADC_INPUT_H_
+
+#include <stdint.h>
+#include "stm32c0xx_hal.h"
+
+extern ADC_HandleTypeDef hadc1;
+
+// Scan order, must match the ranks in MX_ADC1_Init
+#define ADC_RANK_POT          0
+#define ADC_RANK_VREFINT      1
+#define ADC_RANK_TEMPERATURE  2
+#define ADC_CHANNELS          3
+
+#define ADC_SCANS_PER_HALF    8      // Scans in each half of the DMA buffer
+#define ADC_BUFFER_SIZE       (ADC_CHANNELS * ADC_SCANS_PER_HALF * 2)   // Filtered half a buffer at a time
+#define ADC_IIR_SHIFT         2      // IIR smoothing, new = old + (input - old) / 2^ADC_IIR_SHIFT
+#define ADC_HYSTERESIS        6      // adc_input_get() only moves once the filtered value is more than this far away
+#define ADC_SETTLE_BLOCKS     40     // Half buffers without a change before handing over to the analog watchdog, ~270 ms
+#define ADC_REFRESH_BLOCKS    2      // Half buffers tracked by adc_input_refresh()
+#define ADC_WATCH_WINDOW      32     // Watchdog window either side of the settled value
+
+#define ADC_VDDA_NOMINAL_MV      3300   // Reported before the first measurement
+#define ADC_TEMPERATURE_NOMINAL  25
+
+void adc_input_start(void);
+uint16_t adc_input_get(void);
+uint16_t adc_input_full_scale(void);
+uint8_t adc_input_idle(void);
+void adc_input_set_task(uint8_t task_id);
+void adc_input_task(void);
+void adc_input_refresh(void);
+uint16_t adc_input_vdda_mv(void);
+int16_t adc_input_temperature(void);
+void adc_input_dma_IRQHandler(void);
+void adc_input_IRQHandler(void);
+
+
+#endif /* INC_ADC_INPUT_H_ */
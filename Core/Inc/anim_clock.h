@@ -0,0 +1,26 @@
+/*
+ * anim_clock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_ANIM_CLOCK_H_
+#define INC_ANIM_CLOCK_H_
+
+#include <stdint.h>
+
+// A phase accumulator: how far through a repeating cycle an animation is, driven by elapsed time.
+// The whole uint32_t range is one cycle, so phase wraps around by itself and
+// (phase >> 16) * N >> 16 splits a cycle into N equal steps.
+struct AnimPhase {
+	uint32_t phase;
+	uint32_t last;    // Time of the last advance, in ms
+};
+
+void anim_phase_start(struct AnimPhase *anim, uint32_t now);
+uint32_t anim_phase_advance(struct AnimPhase *anim, uint32_t now, uint32_t period_ms);
+uint32_t anim_phase_step(uint32_t phase, uint32_t steps);
+
+
+#endif /* INC_ANIM_CLOCK_H_ */
@@ -0,0 +1,41 @@
+/*
+ * anim_stream.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_ANIM_STREAM_H_
+#define INC_ANIM_STREAM_H_
+
+#include <stdint.h>
+#include "lib_WS2812C.h"
+
+// Compressed animation format, decoded a frame at a time straight out of flash (see anim_stream.c).
+// Made by Tools/anim_encode.py, which documents the authoring side.
+//
+//   Header     version, LED count, frame count (16-bit little endian), colour count, then the colours as R, G, B
+//   Each frame type << 6 | runs, duration in ANIM_TICK_MS ticks, then the body:
+//     KEY      every LED, as runs of [length, colour] adding up to the LED count (runs is unused)
+//     DELTA    runs x [first LED, length, colour], LEDs not covered keep theirs. No runs is a hold.
+// Colours are indices into the header's colour table. The first frame must be a KEY frame, as playback
+// loops back to it after the last frame.
+#define ANIM_FORMAT_VERSION  1
+#define ANIM_TICK_MS         10
+#define ANIM_HEADER_SIZE     5      // Up to the colour table
+#define ANIM_FRAME_KEY       0
+#define ANIM_FRAME_DELTA     1
+#define ANIM_MAX_RUNS        63
+
+// Playback position. Everything else is read from the animation itself.
+struct AnimStream {
+	const uint8_t *data;       // The animation, starting at its header
+	const uint8_t *next;       // Next frame to decode
+	uint16_t frame;            // Index of the next frame
+};
+
+uint8_t anim_stream_start(struct AnimStream *stream, const uint8_t *data);
+uint32_t anim_stream_next(struct AnimStream *stream, struct Colour *frame);
+
+
+#endif /* INC_ANIM_STREAM_H_ */
@@ -0,0 +1,18 @@
+/*
+ * animations.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+// Generated by Tools/anim_encode.py, edit the JSON sources and regenerate rather than this file
+
+#ifndef INC_ANIMATIONS_H_
+#define INC_ANIMATIONS_H_
+
+#include <stdint.h>
+
+extern const uint8_t anim_spinner[742];    // Tools/animations/spinner.json
+
+
+#endif /* INC_ANIMATIONS_H_ */
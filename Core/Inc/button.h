@@ -0,0 +1,29 @@
+/*
+ * button.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_BUTTON_H_
+#define INC_BUTTON_H_
+
+#include <stdint.h>
+#include "stm32c0xx_hal.h"
+
+// PB7, pressed = high
+#define BUTTON_PORT          GPIOB
+#define BUTTON_PIN           GPIO_PIN_7
+
+#define BUTTON_SAMPLE_MS     5      // TIM17 sampling period while the button is active
+#define BUTTON_DEBOUNCE_MS   20     // The pin must read the same for this long to count as a change
+#define BUTTON_LONG_MS       600    // Held this long = long press (reported while still held)
+#define BUTTON_DOUBLE_MS     250    // A second press starting within this long of a release = double press
+
+void button_init(void);
+void button_edge_isr(void);
+uint8_t button_idle(void);
+void button_IRQHandler(void);
+
+
+#endif /* INC_BUTTON_H_ */
@@ -0,0 +1,31 @@
+/*
+ * clock_governor.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_CLOCK_GOVERNOR_H_
+#define INC_CLOCK_GOVERNOR_H_
+
+#include <stdint.h>
+
+#define CLOCK_IDLE_DIV       4      // HSI divider while idle: 1, 2, 4 or 8 (48, 24, 12 or 6 MHz)
+#define CLOCK_HEAVY_PERCENT  25     // A render using more than this % of the frame period keeps full speed
+#define CLOCK_HOLD_FRAMES    50     // ...for this many frames
+
+struct ClockStats {
+	uint32_t switches;         // Clock changes in either direction
+	uint32_t full_us;          // Total time at 48 MHz (wraps after ~71 minutes, use differences)
+	uint32_t reduced_us;       // Total time at 48 MHz / CLOCK_IDLE_DIV
+};
+
+void clock_governor_init(void);
+void clock_governor_full(void);
+void clock_governor_idle(void);
+void clock_governor_report_load(uint32_t busy_us, uint32_t period_us);
+uint32_t clock_governor_divider(void);
+void clock_governor_get_stats(struct ClockStats *stats);
+
+
+#endif /* INC_CLOCK_GOVERNOR_H_ */
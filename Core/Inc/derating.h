@@ -0,0 +1,26 @@
+/*
+ * derating.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_DERATING_H_
+#define INC_DERATING_H_
+
+#include <stdint.h>
+
+#define DERATE_PERIOD_MS         250    // How often the derating task runs
+
+// Output limit falls linearly from 255 at the start point to DERATE_FLOOR at the end point
+#define DERATE_VDDA_START_MV     3100   // Supply sag, VDDA nominal 3.3 V
+#define DERATE_VDDA_END_MV       2800
+#define DERATE_TEMP_START        55     // Die temperature, degrees C
+#define DERATE_TEMP_END          80
+#define DERATE_FLOOR             32     // Never dims below this, so the display is still visibly on
+#define DERATE_RECOVER_STEP      4      // Limit rises by at most this per update, ~16 s from floor to full
+
+uint8_t derate_update(uint16_t vdda_mv, int16_t temperature);
+
+
+#endif /* INC_DERATING_H_ */
@@ -0,0 +1,34 @@
+/*
+ * event_queue.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_EVENT_QUEUE_H_
+#define INC_EVENT_QUEUE_H_
+
+#include <stdint.h>
+
+#define EVENT_QUEUE_SIZE  16    // Must be a power of 2. Holds EVENT_QUEUE_SIZE - 1 events.
+
+enum EventType {
+	EVENT_BUTTON_SHORT,    // PB7 gestures, see button.c
+	EVENT_BUTTON_DOUBLE,
+	EVENT_BUTTON_LONG,
+	EVENT_FRAME_SENT,      // Transmit DMA complete
+	EVENT_CONTROL_CHANGED, // Pot moved, arg is the new adc_input_get() value
+};
+
+struct Event {
+	uint32_t time_us;      // timebase_now_us() when the event was posted
+	uint16_t arg;          // Event specific
+	uint8_t  type;         // enum EventType
+};
+
+uint8_t event_post(uint8_t type, uint16_t arg);
+uint8_t event_get(struct Event *event);
+uint32_t event_dropped_count(void);
+
+
+#endif /* INC_EVENT_QUEUE_H_ */
@@ -0,0 +1,44 @@
+/*
+ * frame_scheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_FRAME_SCHEDULER_H_
+#define INC_FRAME_SCHEDULER_H_
+
+#include <stdint.h>
+#include "lib_WS2812C.h"
+
+#define FRAME_RATE_DEFAULT  50     // fps
+#define FRAME_RATE_MIN      16     // TIM16 counts us, so a longer period doesn't fit in 16 bits
+#define FRAME_RATE_MAX      1000   // Must leave FRAME_CLOCK_LEAD_US inside the period
+#define FRAME_CLOCK_LEAD_US 500    // The clock goes to full speed this long before a vsync with a frame to send
+
+// Fills frame for the next refresh. now is HAL_GetTick() at the vsync that triggered the render.
+// Returns 1 if frame changed and needs sending, 0 to leave the LEDs showing what they already have.
+typedef uint8_t (*FrameRenderCallback)(struct Colour *frame, uint32_t now);
+
+struct FrameStats {
+	uint32_t frames;           // Frames transmitted
+	uint32_t overruns;         // Refreshes where the render, or the clock raise, hadn't finished in time
+	uint32_t period_us;        // Time between refreshes
+	uint32_t last_render_us;   // Time from vsync to the frame being encoded and ready, for the last render
+	uint32_t max_render_us;    // Worst case of last_render_us. Headroom is period_us - max_render_us
+};
+
+void frame_scheduler_init(struct Colour *frame, FrameRenderCallback render, uint16_t fps);
+void frame_scheduler_set_fps(uint16_t fps);
+void frame_scheduler_set_task(uint8_t task_id);
+uint8_t frame_scheduler_poll(void);
+uint8_t frame_scheduler_frame_waiting(void);
+uint8_t frame_scheduler_clock_due(void);
+void frame_scheduler_get_stats(struct FrameStats *stats);
+void frame_scheduler_reset_stats(void);
+uint32_t frame_scheduler_us_until_vsync(void);
+void frame_scheduler_skip_us(uint32_t us);
+void frame_scheduler_IRQHandler(void);
+
+
+#endif /* INC_FRAME_SCHEDULER_H_ */
@@ -10,12 +10,18 @@
 
 #include <stdint.h>
 #include "stm32c0xx_hal.h"
-extern TIM_HandleTypeDef htim1;
 
 #define DISPLAY_WIDTH  3
 #define DISPLAY_HEIGHT 3
 #define NUM_LEDS       9
 
+// RAM budget for the LED buffers, checked at compile time in lib_WS2812C.c
+// The rest of the 6 KB goes to the stack, heap and everything else (the linker checks the total)
+// Tools/ram_report.py shows how these grow with NUM_LEDS
+#define PWM_BUFFER_LENGTH  ((24 * NUM_LEDS) + 600)
+#define LED_RAM_BUDGET     3072
+#define LED_RAM_BYTES      ((PWM_BUFFER_LENGTH * 2) + (NUM_LEDS * 3))
+
 extern volatile uint8_t FLAG_DataSent;
 
 // A struct that holds 3x 8-bit colour values
@@ -32,8 +38,18 @@ void clear_frame(struct Colour *frame);
 struct Colour HuetoRGB(uint16_t Hue);
 void set_colour_whole_frame(struct Colour *frame, struct Colour desired_colour);
 void set_colour_LED(struct Colour *frame, uint32_t LED_number, struct Colour desired_colour);
+void set_brightness(uint8_t level);
+uint8_t get_brightness(void);
+void set_output_limit(uint8_t limit);
+uint8_t get_output_limit(void);
 void send_frame(struct Colour *frame);
-void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim);
+void encode_frame(struct Colour *frame);
+uint32_t get_encode_cycles(void);
+void init_frame_transfer(void);
+uint8_t start_frame_transfer(void);
+uint8_t frame_transfer_busy(void);
+void wait_for_frame_sent(void);
+void frame_transfer_IRQHandler(void);
 
 // Colour Definitions
 
@@ -47,11 +63,5 @@ extern const struct Colour White;
 extern const struct Colour Black;
 
 
-// Patterns
-
-void Pattern_cycle_RGB(struct Colour *frame);
-void Pattern_RainbowGradient(struct Colour *frame);
-//void GradientRainbowDiag(void);
-
 
 #endif /* SRC_LIB_WS2812C_H_ */
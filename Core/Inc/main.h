@@ -46,6 +46,14 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
+// Runs the function from RAM (the .RamFunc section, copied in with .data at startup) rather than flash.
+// For hot loops and ISRs that shouldn't pay the flash wait state at 48 MHz.
+#define RAMFUNC __attribute__((section(".RamFunc")))
+
+// Places buffers whose size scales with NUM_LEDS in their own RAM sections (see STM32C011J4MX_FLASH.ld),
+// so the map file shows what the LED count costs. Both are NOLOAD: startup doesn't zero them.
+#define FRAME_BUFFER  __attribute__((section(".frame_buffers")))
+#define ENCODE_BUFFER __attribute__((section(".encode_buffers")))
 
 /* USER CODE END EM */
 
@@ -55,8 +63,6 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-extern volatile uint8_t FLAG_BTN;
-extern volatile uint32_t value_adc;
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
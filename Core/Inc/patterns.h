@@ -0,0 +1,74 @@
+/*
+ * patterns.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_PATTERNS_H_
+#define INC_PATTERNS_H_
+
+#include <stdint.h>
+#include "lib_WS2812C.h"
+
+// Set any of these to 0 to compile that pattern (and its flash) out of the registry
+#define PATTERN_ENABLE_BLINK           1
+#define PATTERN_ENABLE_RAINBOW         1
+#define PATTERN_ENABLE_CYCLE_RGB       1
+#define PATTERN_ENABLE_SPINNER         0     // Compressed animation from flash, ~1.2 KB with its decoder. Off to fit the 16 KB part
+
+// Bytes reserved for the active pattern's state. Every pattern's state struct must fit.
+#define PATTERN_STATE_SIZE             24
+
+// state_size for a registry entry: sizeof(type), failing the build if it doesn't fit in PATTERN_STATE_SIZE
+#define PATTERN_STATE(type)            (sizeof(type) + 0 * sizeof(struct { \
+		_Static_assert(sizeof(type) <= PATTERN_STATE_SIZE, "Increase PATTERN_STATE_SIZE"); char c; }))
+
+// One entry in the pattern registry
+// Patterns are state machines rather than loops, so the main loop keeps servicing input,
+// the ADC and transmission between frames. Each pattern has:
+//   - init: resets its state and draws its first frame
+//   - step: called every pass of the main loop with the current time in ms and the primary parameter
+//           (speed), returns 1 if it changed the frame (and it needs sending), 0 otherwise.
+//           Steps never wait; if it isn't time for the next frame yet they just return 0.
+//   - state_size: bytes of state it uses, zeroed before init, given with PATTERN_STATE()
+// The meaning and units of speed are up to each pattern; the pot is mapped linearly from
+// speed_min (pot at 0) to speed_max (pot at full scale).
+struct Pattern {
+	void    (*init)(void *state, struct Colour *frame, uint32_t now);
+	uint8_t (*step)(void *state, struct Colour *frame, uint32_t now, uint16_t speed);
+	uint16_t state_size;
+	uint16_t default_speed;
+	uint16_t speed_min;
+	uint16_t speed_max;
+	uint8_t  default_brightness;
+};
+
+extern const struct Pattern pattern_registry[];
+extern const uint8_t NUM_PATTERNS;
+
+// Pattern Selection
+
+void pattern_select(uint8_t index, struct Colour *frame, uint32_t now);
+void pattern_next(struct Colour *frame, uint32_t now);
+void pattern_previous(struct Colour *frame, uint32_t now);
+uint8_t pattern_step(struct Colour *frame, uint32_t now);
+void pattern_set_control(uint32_t value, uint32_t full_scale);
+uint8_t pattern_current(void);
+uint16_t pattern_get_speed(void);
+void pattern_set_speed(uint16_t value);
+
+// Patterns
+
+void Pattern_cycle_RGB_init(void *state, struct Colour *frame, uint32_t now);
+uint8_t Pattern_cycle_RGB_step(void *state, struct Colour *frame, uint32_t now, uint16_t speed);
+void Pattern_RainbowGradient_init(void *state, struct Colour *frame, uint32_t now);
+uint8_t Pattern_RainbowGradient_step(void *state, struct Colour *frame, uint32_t now, uint16_t speed);
+void Pattern_Blink_init(void *state, struct Colour *frame, uint32_t now);
+uint8_t Pattern_Blink_step(void *state, struct Colour *frame, uint32_t now, uint16_t speed);
+void Pattern_Spinner_init(void *state, struct Colour *frame, uint32_t now);
+uint8_t Pattern_Animation_step(void *state, struct Colour *frame, uint32_t now, uint16_t speed);
+//void GradientRainbowDiag(void);
+
+
+#endif /* INC_PATTERNS_H_ */
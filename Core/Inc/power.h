@@ -0,0 +1,41 @@
+/*
+ * power.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_POWER_H_
+#define INC_POWER_H_
+
+#include <stdint.h>
+
+#define POWER_STATIC_FRAMES   10     // Unchanged frames in a row before the scene counts as static
+#define POWER_TICKLESS_MIN_MS 2      // Sleep without SysTick when the next periodic task is at least this far off
+#define POWER_TICKLESS_MAX_MS 60     // Longest single tickless sleep, within TIM14's 16-bit compare range
+#define POWER_STOP_MIN_US     1000   // Don't bother with Stop mode for gaps shorter than this
+#define POWER_WAKE_MARGIN_US  500    // Wake this long before the next vsync, to be running again in time
+
+// RTC, clocked from the 32 kHz LSI and used only to time Stop mode
+#define POWER_RTC_PREDIV_A    1      // 32 kHz / 2 = 16 kHz subsecond counter, 62.5 us resolution
+#define POWER_RTC_PREDIV_S    15999  // Subsecond counter range, so at most ~1 s in Stop at a time
+#define POWER_RTC_TICK_HZ     16000
+
+struct PowerStats {
+	uint32_t sleep_us;         // Total time in Sleep mode (each wraps after ~71 minutes, use differences)
+	uint32_t ticks_skipped;    // SysTick interrupts avoided by tickless sleep
+	uint32_t stop_us;          // Total time in Stop mode
+	uint32_t stops;            // Times Stop mode was entered
+	uint32_t early_wakes;      // Stops ended early by something other than the RTC (e.g. the button)
+	uint32_t wake_latency_us;  // Worst case from the RTC alarm to running again (62.5 us resolution)
+};
+
+void power_init(void);
+void power_wait_for(volatile uint8_t *flag);
+void power_allow_stop(uint8_t allow);
+void power_idle(void);
+void power_get_stats(struct PowerStats *stats);
+void power_rtc_IRQHandler(void);
+
+
+#endif /* INC_POWER_H_ */
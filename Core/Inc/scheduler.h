@@ -0,0 +1,31 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS  8
+
+// Lower numbers run first when several tasks are ready at once
+#define PRIORITY_RENDER      0
+#define PRIORITY_ADC         1
+#define PRIORITY_DERATE      2
+#define PRIORITY_TELEMETRY   3
+#define PRIORITY_SETTINGS    4
+
+// A task runs to completion and must not wait; now is HAL_GetTick() when it was started
+typedef void (*TaskFunction)(uint32_t now);
+
+uint8_t scheduler_add_task(TaskFunction run, uint32_t period_ms, uint8_t priority);
+void scheduler_signal(uint8_t task_id);
+uint8_t scheduler_run(void);
+uint32_t scheduler_ms_until_next(uint32_t now);
+
+
+#endif /* INC_SCHEDULER_H_ */
@@ -0,0 +1,40 @@
+/*
+ * settings.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_SETTINGS_H_
+#define INC_SETTINGS_H_
+
+#include <stdint.h>
+
+#define SETTINGS_PERIOD_MS        100    // How often the settings task looks for something to write
+#define SETTINGS_HOLD_MS          2000   // A change must sit this long before it's written, so a pot turn is one write
+#define SETTINGS_WRITE_GUARD_US   1000   // Only program while the next vsync is at least this far away
+
+// Keys, at most 32. Never renumber: old records would be read back as the wrong setting.
+enum SettingKey {
+	SETTING_PATTERN,
+	SETTING_BRIGHTNESS,
+	SETTING_SPEED,
+	SETTING_KEYS
+};
+
+struct SettingsStats {
+	uint32_t records;          // Records programmed
+	uint32_t erases;           // Page erases
+	uint32_t deferred;         // Task runs where a full page waited for a static scene to be erased
+	uint32_t errors;           // Failed programs or erases
+};
+
+void settings_init(void);
+uint8_t settings_get(uint8_t key, uint32_t *value);
+void settings_set(uint8_t key, uint32_t value);
+void settings_allow_erase(uint8_t allow);
+void settings_task(uint32_t now);
+void settings_get_stats(struct SettingsStats *out);
+
+
+#endif /* INC_SETTINGS_H_ */
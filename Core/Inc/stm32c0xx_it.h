@@ -52,8 +52,14 @@ void SVC_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
 void EXTI4_15_IRQHandler(void);
-void DMA1_Channel1_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel2_3_IRQHandler(void);
+void ADC1_IRQHandler(void);
+void TIM14_IRQHandler(void);
+void TIM16_IRQHandler(void);
+void TIM17_IRQHandler(void);
+void RTC_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,30 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include <stdint.h>
+#include "stm32c0xx_hal.h"
+
+// 32-bit microsecond monotonic clock on TIM14 (wraps every ~71.6 minutes)
+// Compare times with unsigned subtraction, e.g. timebase_elapsed_us(start), so wraparound doesn't matter.
+
+#define TIMEBASE_HZ          1000000   // TIM14, and every timer retuned along with it (TIM16, TIM17), counts us
+#define TIMEBASE_MAX_TIMERS  3         // Most timers timebase_retune_timers() takes at once
+
+void timebase_init(void);
+void timebase_retune_timers(TIM_TypeDef *const *timers, uint32_t num_timers, uint32_t new_hz, void (*switch_clock)(void));
+uint32_t timebase_now_us(void);
+uint32_t timebase_elapsed_us(uint32_t start);
+void timebase_skip_us(uint32_t us);
+void timebase_set_alarm_us(uint32_t us);
+void timebase_cancel_alarm(void);
+void timebase_IRQHandler(void);
+
+
+#endif /* INC_TIMEBASE_H_ */
@@ -0,0 +1,337 @@
+/*
+ * adc_input.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Pot reading (ADC1 channel 12), supply voltage and chip temperature without ever waiting on a conversion.
+ *
+ * ADC1 continuously scans the pot, VREFINT and the temperature sensor (ranks 1 - 3) and DMA1 channel 2 writes
+ * the results round a circular buffer, ADC_CHANNELS samples per scan. Each time half the buffer fills, the
+ * DMA interrupt filters that half. For the pot:
+ *   - its samples in the half are averaged into one block value
+ *   - the median of the last 3 block values throws away any single bad block (e.g. a spike from LED current)
+ *   - a fixed-point first order IIR smooths what's left
+ *   - hysteresis stops the reported value dithering between two neighbouring counts
+ * The result is stored, so adc_input_get() is just a memory load and can be called as often as needed.
+ * The first half buffer after adc_input_start() seeds the filter instead, so nothing ever waits on a
+ * conversion; until then adc_input_get() reads 0.
+ *
+ * Most of the averaging is done by the ADC's hardware oversampler rather than the CPU. Its ratio and shift
+ * are set in MX_ADC1_Init (Light-Array-9.ioc); currently 12-bit conversions, ratio 16, shift 4, giving a
+ * 16x averaged 12-bit result. adc_input_full_scale() works the full scale out from that configuration,
+ * so changing the ratio/shift in CubeMX (e.g. ratio 64, shift 4 for 14 bits) needs no changes here.
+ *
+ * Each oversampled result is 16 conversions of (39.5 + 12.5) cycles at a 3 MHz ADC clock, ~280 us, which is
+ * also comfortably over the 5 us minimum sampling time of the internal channels. A scan is ~830 us, so the
+ * filter runs roughly every 6.7 ms.
+ *
+ * VREFINT and the temperature sensor are just averaged over the half. VREFINT against its factory calibration
+ * gives the real VDDA, which the temperature is then worked out against (see adc_input_vdda_mv()).
+ *
+ * The pot is left alone nearly all the time, so filtering it every 6.7 ms is mostly wasted. Once the reading
+ * hasn't changed for ADC_SETTLE_BLOCKS half buffers the DMA is stopped and the ADC carries on scanning with
+ * only analog watchdog 1 looking at the pot results, windowed ADC_WATCH_WINDOW either side of the settled value.
+ * Nothing runs on the CPU until the knob is turned out of the window; the watchdog interrupt then restarts
+ * the DMA and filter, which re-centre the window when the pot settles again.
+ *
+ *   TRACKING --(no change for ADC_SETTLE_BLOCKS)--> WATCHING --(watchdog out of window)--> TRACKING
+ *
+ * A mode change stops conversions and waits for the ADC to acknowledge, so it's kept out of the interrupts.
+ * The interrupt that wants a change only masks itself in the NVIC and signals the task set with
+ * adc_input_set_task(), and adc_input_task() makes the change from the main loop. The ADC's interrupt
+ * enables can't be written while it's converting, hence the NVIC. With the interrupt that asked masked,
+ * and the other one not running in that mode, no ADC or DMA interrupt can land in the middle of a change.
+ *
+ * Every change to adc_input_get() is also posted as EVENT_CONTROL_CHANGED, so nothing needs to poll it.
+ * While watching, the supply and temperature readings only update when adc_input_refresh() asks for a
+ * short burst of tracking.
+ */
+
+#include "adc_input.h"
+#include "event_queue.h"
+#include "scheduler.h"
+#include "main.h"
+#include "stm32c0xx_ll_dma.h"
+
+#define IIR_FRACTION 4     // Fractional bits kept in the IIR state
+#define TEMPSENSOR_AVG_SLOPE_UV  2530    // Datasheet typical slope, uV per degree C
+
+static uint16_t buffer[ADC_BUFFER_SIZE];
+static uint16_t blocks[3];                 // Last 3 half-buffer averages, for the median
+static uint32_t iir;                       // Filter state, value << IIR_FRACTION
+static volatile uint16_t filtered = 0;       // Filtered value after hysteresis, what adc_input_get() returns
+static uint8_t primed = 0;                 // Set once the first half buffer has seeded the filter
+static uint16_t full_scale = 4095;
+static volatile uint16_t vrefint_raw;      // Half buffer averages of the internal channels
+static volatile uint16_t temperature_raw;
+
+enum AdcMode {
+	ADC_MODE_TRACKING,     // DMA running, filter runs every half buffer
+	ADC_MODE_WATCHING,     // DMA stopped, analog watchdog waiting for the pot to move
+};
+static volatile uint8_t mode = ADC_MODE_TRACKING;
+static volatile uint8_t requested = ADC_MODE_TRACKING;   // Mode asked for by the interrupts, see adc_input_task()
+static uint16_t quiet_blocks;              // Half buffers since the filtered value last changed
+static uint8_t mode_task;
+static uint8_t mode_task_set = 0;
+
+// Largest value the oversampler can produce: (2^resolution - 1) * ratio >> shift
+static uint16_t calculate_full_scale(void) {
+	uint32_t bits  = 12 - 2 * ((hadc1.Init.Resolution & ADC_CFGR1_RES) >> ADC_CFGR1_RES_Pos);
+	uint32_t value = (1UL << bits) - 1;
+
+	if (hadc1.Init.OversamplingMode == ENABLE) {
+		uint32_t ratio = 2UL << ((hadc1.Init.Oversampling.Ratio & ADC_CFGR2_OVSR) >> ADC_CFGR2_OVSR_Pos);
+		uint32_t shift = (hadc1.Init.Oversampling.RightBitShift & ADC_CFGR2_OVSS) >> ADC_CFGR2_OVSS_Pos;
+		value = (value * ratio) >> shift;
+	}
+
+	return (value > 0xFFFF) ? 0xFFFF : value;   // The data register is 16 bits, anything more is a config error
+}
+
+// Watchdog threshold for a reading. With oversampling on, AWD1 compares against bits [15:4] of the result.
+static uint32_t watchdog_threshold(int32_t value) {
+	if (value < 0) value = 0;
+	if (value > full_scale) value = full_scale;
+
+	if (hadc1.Init.OversamplingMode == ENABLE) return (uint32_t)value >> 4;
+	return __LL_ADC_ANALOGWD_SET_THRESHOLD_RESOLUTION(hadc1.Init.Resolution, (uint32_t)value);
+}
+
+// Unmasks whichever interrupt asked for the mode change, once the change is made
+static void unmask_interrupts(void) {
+	HAL_NVIC_ClearPendingIRQ(DMA1_Channel2_3_IRQn);
+	HAL_NVIC_ClearPendingIRQ(ADC1_IRQn);
+	HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+	HAL_NVIC_EnableIRQ(ADC1_IRQn);
+}
+
+// Stops conversions and the DMA. ADSTP aborts the conversion in progress, so this only waits a few ADC clocks.
+static void stop_conversions(void) {
+	LL_ADC_REG_StopConversion(ADC1);
+	while (LL_ADC_REG_IsConversionOngoing(ADC1)) {}
+
+	LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_2);
+	LL_ADC_REG_SetDMATransfer(ADC1, LL_ADC_REG_DMA_TRANSFER_NONE);
+}
+
+// The watchdog thresholds can only be written while conversions are stopped, so both mode changes restart them.
+// Register level rather than HAL_ADC_Start_DMA() and friends, for the same reason as the LED transmit path
+// (lib_WS2812C.c): HAL's start/stop/IRQ handling cost ~3 KB of flash, and the part only has 16 KB.
+// Main loop only, see adc_input_task().
+static void start_tracking(void) {
+	LL_ADC_ConfigAnalogWDThresholds(ADC1, LL_ADC_AWD1, watchdog_threshold(full_scale), watchdog_threshold(0));
+
+	LL_DMA_SetMemoryAddress(DMA1, LL_DMA_CHANNEL_2, (uint32_t)buffer);
+	LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_2, ADC_BUFFER_SIZE);
+	LL_DMA_ClearFlag_GI2(DMA1);
+	LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_2);
+	LL_ADC_REG_SetDMATransfer(ADC1, LL_ADC_REG_DMA_TRANSFER_UNLIMITED);
+
+	quiet_blocks = 0;
+	mode = ADC_MODE_TRACKING;
+	LL_ADC_REG_StartConversion(ADC1);
+	unmask_interrupts();
+}
+
+static void start_watching(void) {
+	stop_conversions();
+
+	LL_ADC_ConfigAnalogWDThresholds(ADC1, LL_ADC_AWD1,
+			watchdog_threshold((int32_t)filtered + ADC_WATCH_WINDOW),
+			watchdog_threshold((int32_t)filtered - ADC_WATCH_WINDOW));
+	LL_ADC_ClearFlag_AWD1(ADC1);
+
+	mode = ADC_MODE_WATCHING;
+	LL_ADC_REG_StartConversion(ADC1);
+	unmask_interrupts();
+}
+
+// Calibrates and enables ADC1. It then stays enabled; mode changes only stop and start conversions.
+static void calibrate_and_enable(void) {
+	LL_ADC_StartCalibration(ADC1);
+	while (LL_ADC_IsCalibrationOnGoing(ADC1)) {}
+
+	// ADEN can't be set for LL_ADC_DELAY_CALIB_ENABLE_ADC_CYCLES (2) ADC clocks after calibration,
+	// 32 core clocks at the /16 ADC clock. The loop takes several times that.
+	for (volatile uint8_t i = 0; i < 32; i++) {}
+
+	LL_ADC_ClearFlag_ADRDY(ADC1);
+	LL_ADC_Enable(ADC1);
+	while (!LL_ADC_IsActiveFlag_ADRDY(ADC1)) {}
+}
+
+// Called from the ADC and DMA interrupts, once they've masked themselves
+static void request_mode(uint8_t new_mode) {
+	requested = new_mode;
+	if (mode_task_set) scheduler_signal(mode_task);
+}
+
+// Calibrates ADC1 and starts continuous conversions. Call once, after MX_ADC1_Init().
+// MX_ADC1_Init() leaves the DMA channel and analog watchdog 1 to here: the DMA addresses are set on every
+// start, and the watchdog's thresholds belong to the filter.
+void adc_input_start(void) {
+	full_scale = calculate_full_scale();
+
+	calibrate_and_enable();
+
+	LL_DMA_SetPeriphAddress(DMA1, LL_DMA_CHANNEL_2, (uint32_t)&ADC1->DR);
+	LL_DMA_EnableIT_HT(DMA1, LL_DMA_CHANNEL_2);
+	LL_DMA_EnableIT_TC(DMA1, LL_DMA_CHANNEL_2);
+
+	LL_ADC_SetAnalogWDMonitChannels(ADC1, LL_ADC_AWD1, LL_ADC_AWD_CHANNEL_12_REG);
+	LL_ADC_EnableIT_AWD1(ADC1);
+
+	filtered = 0;
+	primed = 0;
+	requested = ADC_MODE_TRACKING;
+
+	// Nominal values until the first half buffer arrives, so nothing derates at power up
+	vrefint_raw = 0;
+	temperature_raw = 0;
+
+	start_tracking();
+}
+
+// Latest filtered pot reading, 0 - adc_input_full_scale(). 0 until the first half buffer, ~7 ms after starting.
+uint16_t adc_input_get(void) {
+	return filtered;
+}
+
+uint16_t adc_input_full_scale(void) {
+	return full_scale;
+}
+
+// 1 while only the analog watchdog is running, i.e. the ADC needs no CPU time
+uint8_t adc_input_idle(void) {
+	return mode == ADC_MODE_WATCHING;
+}
+
+// Signals task_id (see scheduler.c) whenever the ADC needs to change mode
+void adc_input_set_task(uint8_t task_id) {
+	mode_task = task_id;
+	mode_task_set = 1;
+	if (requested != mode) scheduler_signal(mode_task);   // Asked for before there was a task to signal
+}
+
+// Makes the mode change the interrupts asked for. Call from the main loop, or the task set with
+// adc_input_set_task(). Without a task it has to be polled, or the ADC stays in whichever mode it was in.
+void adc_input_task(void) {
+	if (requested == mode) return;
+
+	if (requested == ADC_MODE_WATCHING) {
+		start_watching();
+	} else {
+		stop_conversions();
+		start_tracking();
+	}
+}
+
+// While watching, runs the DMA for ADC_REFRESH_BLOCKS half buffers to update the supply and temperature readings.
+// Main loop only. The watchdog interrupt is masked first, so it can't ask for the same change meanwhile.
+void adc_input_refresh(void) {
+	if (mode != ADC_MODE_WATCHING) return;
+
+	HAL_NVIC_DisableIRQ(ADC1_IRQn);
+	requested = ADC_MODE_TRACKING;
+	stop_conversions();
+	start_tracking();
+	quiet_blocks = ADC_SETTLE_BLOCKS - ADC_REFRESH_BLOCKS;
+}
+
+// Rescales an internal channel reading to the 12 bits the calibration values are stored at
+static uint32_t to_12_bit(uint32_t value) {
+	return (value * 4095) / full_scale;
+}
+
+// VDDA in mV, from VREFINT and its factory calibration (measured at 3.0 V)
+uint16_t adc_input_vdda_mv(void) {
+	uint32_t vrefint = to_12_bit(vrefint_raw);
+	if (vrefint == 0) return ADC_VDDA_NOMINAL_MV;
+	return __LL_ADC_CALC_VREFANALOG_VOLTAGE(vrefint, LL_ADC_RESOLUTION_12B);
+}
+
+// Chip temperature in degrees C, from TS_CAL1 (30 C at 3.0 V) and the typical slope
+int16_t adc_input_temperature(void) {
+	if (temperature_raw == 0) return ADC_TEMPERATURE_NOMINAL;
+
+	int32_t sensor_mv = (to_12_bit(temperature_raw) * adc_input_vdda_mv()) / 4095;
+	int32_t cal_mv    = ((uint32_t)*TEMPSENSOR_CAL1_ADDR * TEMPSENSOR_CAL_VREFANALOG) / 4095;
+
+	return TEMPSENSOR_CAL1_TEMP + ((sensor_mv - cal_mv) * 1000) / TEMPSENSOR_AVG_SLOPE_UV;
+}
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+	if (a > b) { uint16_t t = a; a = b; b = t; }
+	if (b > c) b = c;
+	return (a > b) ? a : b;
+}
+
+static void filter_half(const uint16_t *half) {
+	uint32_t sum[ADC_CHANNELS] = {0};
+	for (uint8_t i = 0; i < ADC_BUFFER_SIZE / 2; i += ADC_CHANNELS) {
+		for (uint8_t c = 0; c < ADC_CHANNELS; c++) {
+			sum[c] += half[i + c];
+		}
+	}
+
+	vrefint_raw     = sum[ADC_RANK_VREFINT]     / ADC_SCANS_PER_HALF;
+	temperature_raw = sum[ADC_RANK_TEMPERATURE] / ADC_SCANS_PER_HALF;
+
+	uint16_t block = sum[ADC_RANK_POT] / ADC_SCANS_PER_HALF;
+
+	if (!primed) {
+		// First half buffer since adc_input_start(), start the filter here rather than ramping up from 0
+		blocks[0] = blocks[1] = blocks[2] = block;
+		iir = (uint32_t)block << IIR_FRACTION;
+		filtered = block;
+		primed = 1;
+		event_post(EVENT_CONTROL_CHANGED, block);
+		return;
+	}
+
+	blocks[0] = blocks[1];
+	blocks[1] = blocks[2];
+	blocks[2] = block;
+
+	uint32_t input = (uint32_t)median3(blocks[0], blocks[1], blocks[2]) << IIR_FRACTION;
+	iir = iir + ((int32_t)(input - iir) >> ADC_IIR_SHIFT);
+
+	uint16_t value = (iir + (1 << (IIR_FRACTION - 1))) >> IIR_FRACTION;   // Rounded
+
+	// Hysteresis, except at the ends of the range so full scale and zero are still reachable
+	int32_t moved = (int32_t)value - filtered;
+	if (value != filtered && (moved > ADC_HYSTERESIS || moved < -ADC_HYSTERESIS || value == 0 || value == full_scale)) {
+		filtered = value;
+		quiet_blocks = 0;
+		event_post(EVENT_CONTROL_CHANGED, value);
+	} else if (++quiet_blocks >= ADC_SETTLE_BLOCKS) {
+		// No more half buffers until adc_input_task() has stopped the DMA
+		HAL_NVIC_DisableIRQ(DMA1_Channel2_3_IRQn);
+		request_mode(ADC_MODE_WATCHING);
+	}
+}
+
+// Called from DMA1_Channel2_3_IRQHandler, each time half the buffer fills
+void adc_input_dma_IRQHandler(void) {
+	if (LL_DMA_IsActiveFlag_HT2(DMA1)) {
+		LL_DMA_ClearFlag_HT2(DMA1);
+		filter_half(&buffer[0]);
+	}
+	if (LL_DMA_IsActiveFlag_TC2(DMA1)) {
+		LL_DMA_ClearFlag_TC2(DMA1);
+		filter_half(&buffer[ADC_BUFFER_SIZE / 2]);
+	}
+}
+
+// Called from ADC1_IRQHandler. Analog watchdog 1 is the only interrupt enabled: the pot has moved out of the
+// window while watching. Stays masked until the next mode change, as the flag comes straight back while the
+// pot is outside the window.
+void adc_input_IRQHandler(void) {
+	LL_ADC_ClearFlag_AWD1(ADC1);
+	HAL_NVIC_DisableIRQ(ADC1_IRQn);
+	if (mode == ADC_MODE_WATCHING) request_mode(ADC_MODE_TRACKING);
+}
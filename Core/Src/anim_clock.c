@@ -0,0 +1,42 @@
+/*
+ * anim_clock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Animations are driven by elapsed time rather than by counting frames, so their speed doesn't depend on
+ * how long encoding and transmission take, or on how often the main loop gets round to them.
+ * If frames are dropped the next one just lands further along the cycle.
+ *
+ * The phase is accumulated (rather than computed as now / period) so the period can change mid-animation
+ * (e.g. from the pot) without the animation jumping to a different place in its cycle.
+ */
+
+#include "anim_clock.h"
+
+// Starts a cycle at phase 0
+void anim_phase_start(struct AnimPhase *anim, uint32_t now) {
+	anim->phase = 0;
+	anim->last = now;
+}
+
+// Moves the phase along by the time elapsed since the last advance, at one full cycle per period_ms
+// Returns the new phase
+uint32_t anim_phase_advance(struct AnimPhase *anim, uint32_t now, uint32_t period_ms) {
+	uint32_t elapsed = now - anim->last;   // Unsigned difference survives tick wraparound
+	anim->last = now;
+
+	if (period_ms == 0) period_ms = 1;
+
+	// elapsed * rate can overflow when more than a whole cycle has passed, but the phase only needs
+	// to be right modulo one cycle, which is exactly what the wraparound gives
+	anim->phase += elapsed * (UINT32_MAX / period_ms);
+	return anim->phase;
+}
+
+// Which of steps equal steps (0 - steps-1) through the cycle a phase falls in
+uint32_t anim_phase_step(uint32_t phase, uint32_t steps) {
+	return ((phase >> 16) * steps) >> 16;
+}
@@ -0,0 +1,85 @@
+/*
+ * anim_stream.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Streaming decoder for the compressed animations in animations.c (format in anim_stream.h).
+ *
+ * Raw frames cost 3 bytes per LED each, so 16 KB of flash would hold only a few seconds of them. Designer
+ * animations are mostly a few LEDs changing at a time over held colours and use only a few colours, so
+ * they're stored as a key frame followed by deltas against the frame before, with runs of one colour
+ * collapsed and each colour a 1 byte index into a table. That typically gets a frame down to a handful of
+ * bytes, and a long hold costs 2.
+ *
+ * Nothing is decompressed up front. The decoder keeps a pointer into flash and applies one frame at a time to
+ * the frame buffer it's given, so it needs no RAM of its own and decoding a frame is a few hundred cycles
+ * at most. Indices and lengths are clamped to NUM_LEDS, so a bad animation can't write outside the frame.
+ */
+
+#include "anim_stream.h"
+
+static uint16_t frame_count(const uint8_t *data) {
+	return data[2] | (data[3] << 8);
+}
+
+static const uint8_t *first_frame(const uint8_t *data) {
+	return data + ANIM_HEADER_SIZE + 3 * data[4];
+}
+
+// Checks the header and rewinds to the first frame. Returns 0 if the animation wasn't made for this display.
+uint8_t anim_stream_start(struct AnimStream *stream, const uint8_t *data) {
+	stream->data = data;
+	stream->next = first_frame(data);
+	stream->frame = 0;
+
+	if (data[0] != ANIM_FORMAT_VERSION || data[1] != NUM_LEDS || frame_count(data) == 0 || data[4] == 0) return 0;
+	return (stream->next[0] >> 6) == ANIM_FRAME_KEY;
+}
+
+static void fill_run(const struct AnimStream *stream, struct Colour *frame, uint32_t first, uint32_t length, uint8_t index) {
+	if (index >= stream->data[4]) index = 0;
+	const uint8_t *rgb = stream->data + ANIM_HEADER_SIZE + 3 * index;
+	struct Colour colour = create_colour(rgb[0], rgb[1], rgb[2]);
+
+	if (first >= NUM_LEDS) return;
+	if (length > NUM_LEDS - first) length = NUM_LEDS - first;
+	for (uint32_t LED = first; LED < first + length; LED++) {
+		frame[LED] = colour;
+	}
+}
+
+// Applies the next frame to frame, looping back to the start after the last one
+// Returns how long the frame is to be shown for, in ms
+uint32_t anim_stream_next(struct AnimStream *stream, struct Colour *frame) {
+	if (stream->frame >= frame_count(stream->data)) {
+		stream->next = first_frame(stream->data);
+		stream->frame = 0;
+	}
+
+	const uint8_t *p = stream->next;
+	uint8_t type = p[0] >> 6;
+	uint8_t runs = p[0] & ANIM_MAX_RUNS;
+	uint32_t duration = p[1] ? p[1] : 1;
+	p += 2;
+
+	if (type == ANIM_FRAME_KEY) {
+		for (uint32_t LED = 0; LED < NUM_LEDS; ) {
+			uint32_t length = p[0] ? p[0] : 1;    // A 0 length would never finish
+			fill_run(stream, frame, LED, length, p[1]);
+			LED += length;
+			p += 2;
+		}
+	} else {
+		for (uint8_t run = 0; run < runs; run++) {
+			fill_run(stream, frame, p[0], p[1], p[2]);
+			p += 3;
+		}
+	}
+
+	stream->next = p;
+	stream->frame++;
+	return duration * ANIM_TICK_MS;
+}
@@ -0,0 +1,62 @@
+/*
+ * animations.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+// Generated by Tools/anim_encode.py, edit the JSON sources and regenerate rather than this file
+// Format in anim_stream.h
+
+#include "animations.h"
+
+// Tools/animations/spinner.json
+const uint8_t anim_spinner[742] = {
+	0x01, 0x09, 0x36, 0x00, 0x0D, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x59, 0x00, 0x00, 0x26, 0x00,
+	0x00, 0x19, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x59, 0x00, 0x00, 0x26, 0x00, 0x00, 0x19, 0x00,
+	0x00, 0x00, 0xFF, 0x00, 0x00, 0x59, 0x00, 0x00, 0x26, 0x00, 0x00, 0x19, 0x00, 0x06, 0x01, 0x00,
+	0x02, 0x01, 0x01, 0x02, 0x01, 0x03, 0x01, 0x01, 0x01, 0x04, 0x02, 0x01, 0x00, 0x06, 0x01, 0x02,
+	0x01, 0x00, 0x01, 0x01, 0x01, 0x04, 0x01, 0x03, 0x04, 0x01, 0x00, 0x06, 0x01, 0x04, 0x01, 0x02,
+	0x01, 0x00, 0x01, 0x01, 0x01, 0x03, 0x04, 0x01, 0x44, 0x06, 0x00, 0x01, 0x01, 0x01, 0x01, 0x04,
+	0x02, 0x01, 0x02, 0x05, 0x01, 0x00, 0x44, 0x06, 0x01, 0x01, 0x01, 0x02, 0x01, 0x04, 0x05, 0x01,
+	0x02, 0x08, 0x01, 0x00, 0x00, 0x06, 0x04, 0x01, 0x01, 0x03, 0x01, 0x04, 0x01, 0x01, 0x01, 0x00,
+	0x01, 0x02, 0x00, 0x06, 0x04, 0x01, 0x01, 0x03, 0x01, 0x01, 0x01, 0x00, 0x01, 0x02, 0x01, 0x04,
+	0x44, 0x06, 0x03, 0x01, 0x00, 0x06, 0x01, 0x02, 0x07, 0x01, 0x04, 0x08, 0x01, 0x01, 0x44, 0x06,
+	0x00, 0x01, 0x00, 0x03, 0x01, 0x02, 0x06, 0x01, 0x04, 0x07, 0x01, 0x01, 0x00, 0x06, 0x01, 0x02,
+	0x01, 0x00, 0x01, 0x01, 0x01, 0x04, 0x01, 0x03, 0x04, 0x01, 0x00, 0x06, 0x01, 0x04, 0x01, 0x02,
+	0x01, 0x00, 0x01, 0x01, 0x01, 0x03, 0x04, 0x01, 0x44, 0x06, 0x00, 0x01, 0x01, 0x01, 0x01, 0x04,
+	0x02, 0x01, 0x02, 0x05, 0x01, 0x00, 0x44, 0x06, 0x01, 0x01, 0x01, 0x02, 0x01, 0x04, 0x05, 0x01,
+	0x02, 0x08, 0x01, 0x00, 0x00, 0x06, 0x04, 0x01, 0x01, 0x03, 0x01, 0x04, 0x01, 0x01, 0x01, 0x00,
+	0x01, 0x02, 0x00, 0x06, 0x04, 0x01, 0x01, 0x03, 0x01, 0x01, 0x01, 0x00, 0x01, 0x02, 0x01, 0x04,
+	0x44, 0x06, 0x03, 0x01, 0x00, 0x06, 0x01, 0x02, 0x07, 0x01, 0x04, 0x08, 0x01, 0x01, 0x00, 0x34,
+	0x09, 0x00, 0x00, 0x14, 0x09, 0x01, 0x44, 0x06, 0x00, 0x01, 0x05, 0x03, 0x01, 0x06, 0x04, 0x01,
+	0x07, 0x06, 0x01, 0x08, 0x00, 0x06, 0x01, 0x06, 0x01, 0x05, 0x01, 0x01, 0x01, 0x08, 0x01, 0x07,
+	0x04, 0x01, 0x00, 0x06, 0x01, 0x08, 0x01, 0x06, 0x01, 0x05, 0x01, 0x01, 0x01, 0x07, 0x04, 0x01,
+	0x44, 0x06, 0x00, 0x01, 0x01, 0x01, 0x01, 0x08, 0x02, 0x01, 0x06, 0x05, 0x01, 0x05, 0x44, 0x06,
+	0x01, 0x01, 0x01, 0x02, 0x01, 0x08, 0x05, 0x01, 0x06, 0x08, 0x01, 0x05, 0x00, 0x06, 0x04, 0x01,
+	0x01, 0x07, 0x01, 0x08, 0x01, 0x01, 0x01, 0x05, 0x01, 0x06, 0x00, 0x06, 0x04, 0x01, 0x01, 0x07,
+	0x01, 0x01, 0x01, 0x05, 0x01, 0x06, 0x01, 0x08, 0x44, 0x06, 0x03, 0x01, 0x05, 0x06, 0x01, 0x06,
+	0x07, 0x01, 0x08, 0x08, 0x01, 0x01, 0x44, 0x06, 0x00, 0x01, 0x05, 0x03, 0x01, 0x06, 0x06, 0x01,
+	0x08, 0x07, 0x01, 0x01, 0x00, 0x06, 0x01, 0x06, 0x01, 0x05, 0x01, 0x01, 0x01, 0x08, 0x01, 0x07,
+	0x04, 0x01, 0x00, 0x06, 0x01, 0x08, 0x01, 0x06, 0x01, 0x05, 0x01, 0x01, 0x01, 0x07, 0x04, 0x01,
+	0x44, 0x06, 0x00, 0x01, 0x01, 0x01, 0x01, 0x08, 0x02, 0x01, 0x06, 0x05, 0x01, 0x05, 0x44, 0x06,
+	0x01, 0x01, 0x01, 0x02, 0x01, 0x08, 0x05, 0x01, 0x06, 0x08, 0x01, 0x05, 0x00, 0x06, 0x04, 0x01,
+	0x01, 0x07, 0x01, 0x08, 0x01, 0x01, 0x01, 0x05, 0x01, 0x06, 0x00, 0x06, 0x04, 0x01, 0x01, 0x07,
+	0x01, 0x01, 0x01, 0x05, 0x01, 0x06, 0x01, 0x08, 0x44, 0x06, 0x03, 0x01, 0x05, 0x06, 0x01, 0x06,
+	0x07, 0x01, 0x08, 0x08, 0x01, 0x01, 0x00, 0x34, 0x09, 0x05, 0x00, 0x14, 0x09, 0x01, 0x44, 0x06,
+	0x00, 0x01, 0x09, 0x03, 0x01, 0x0A, 0x04, 0x01, 0x0B, 0x06, 0x01, 0x0C, 0x00, 0x06, 0x01, 0x0A,
+	0x01, 0x09, 0x01, 0x01, 0x01, 0x0C, 0x01, 0x0B, 0x04, 0x01, 0x00, 0x06, 0x01, 0x0C, 0x01, 0x0A,
+	0x01, 0x09, 0x01, 0x01, 0x01, 0x0B, 0x04, 0x01, 0x44, 0x06, 0x00, 0x01, 0x01, 0x01, 0x01, 0x0C,
+	0x02, 0x01, 0x0A, 0x05, 0x01, 0x09, 0x44, 0x06, 0x01, 0x01, 0x01, 0x02, 0x01, 0x0C, 0x05, 0x01,
+	0x0A, 0x08, 0x01, 0x09, 0x00, 0x06, 0x04, 0x01, 0x01, 0x0B, 0x01, 0x0C, 0x01, 0x01, 0x01, 0x09,
+	0x01, 0x0A, 0x00, 0x06, 0x04, 0x01, 0x01, 0x0B, 0x01, 0x01, 0x01, 0x09, 0x01, 0x0A, 0x01, 0x0C,
+	0x44, 0x06, 0x03, 0x01, 0x09, 0x06, 0x01, 0x0A, 0x07, 0x01, 0x0C, 0x08, 0x01, 0x01, 0x44, 0x06,
+	0x00, 0x01, 0x09, 0x03, 0x01, 0x0A, 0x06, 0x01, 0x0C, 0x07, 0x01, 0x01, 0x00, 0x06, 0x01, 0x0A,
+	0x01, 0x09, 0x01, 0x01, 0x01, 0x0C, 0x01, 0x0B, 0x04, 0x01, 0x00, 0x06, 0x01, 0x0C, 0x01, 0x0A,
+	0x01, 0x09, 0x01, 0x01, 0x01, 0x0B, 0x04, 0x01, 0x44, 0x06, 0x00, 0x01, 0x01, 0x01, 0x01, 0x0C,
+	0x02, 0x01, 0x0A, 0x05, 0x01, 0x09, 0x44, 0x06, 0x01, 0x01, 0x01, 0x02, 0x01, 0x0C, 0x05, 0x01,
+	0x0A, 0x08, 0x01, 0x09, 0x00, 0x06, 0x04, 0x01, 0x01, 0x0B, 0x01, 0x0C, 0x01, 0x01, 0x01, 0x09,
+	0x01, 0x0A, 0x00, 0x06, 0x04, 0x01, 0x01, 0x0B, 0x01, 0x01, 0x01, 0x09, 0x01, 0x0A, 0x01, 0x0C,
+	0x44, 0x06, 0x03, 0x01, 0x09, 0x06, 0x01, 0x0A, 0x07, 0x01, 0x0C, 0x08, 0x01, 0x01, 0x00, 0x34,
+	0x09, 0x09, 0x00, 0x14, 0x09, 0x01,
+};
@@ -0,0 +1,148 @@
+/*
+ * button.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Debouncing and gesture recognition for the PB7 button.
+ *
+ * The EXTI interrupt only wakes this up. On the first edge the EXTI line is masked (so contact bounce can't
+ * cause any more interrupts) and TIM17 starts sampling the pin every BUTTON_SAMPLE_MS. The samples are
+ * debounced and fed through a small state machine that posts exactly one event per gesture:
+ *   - EVENT_BUTTON_SHORT   pressed and released, with no second press following
+ *   - EVENT_BUTTON_DOUBLE  a second press within BUTTON_DOUBLE_MS of the first release
+ *   - EVENT_BUTTON_LONG    held for BUTTON_LONG_MS (posted while still held)
+ * Once the gesture is over and the button is released, TIM17 stops and the EXTI line is unmasked again.
+ *
+ * TIM17 runs at the same NVIC priority as the other ISRs that post events, see event_queue.c.
+ */
+
+#include "button.h"
+#include "event_queue.h"
+#include "timebase.h"
+
+#define DEBOUNCE_SAMPLES   (BUTTON_DEBOUNCE_MS / BUTTON_SAMPLE_MS)
+#define LONG_SAMPLES       (BUTTON_LONG_MS / BUTTON_SAMPLE_MS)
+#define DOUBLE_SAMPLES     (BUTTON_DOUBLE_MS / BUTTON_SAMPLE_MS)
+#define TICK_HZ            TIMEBASE_HZ    // TIM17 counts us, like every timer the clock governor retunes
+
+enum ButtonState {
+	BUTTON_IDLE,           // Not sampling, waiting on the EXTI
+	BUTTON_WAIT_PRESS,     // Edge seen, waiting for the press to settle (or turn out to be noise)
+	BUTTON_PRESSED,        // Down, timing for a long press
+	BUTTON_WAIT_SECOND,    // Released after a short press, waiting to see if a second press follows
+	BUTTON_WAIT_RELEASE,   // Gesture reported, waiting for the button to be let go
+};
+
+static volatile uint8_t state = BUTTON_IDLE;
+static uint8_t  stable_pressed;   // Debounced pin state
+static uint8_t  same_count;       // Consecutive samples that disagree with stable_pressed
+static uint16_t timer;            // Samples spent in the current state
+
+void button_init(void) {
+	__HAL_RCC_TIM17_CLK_ENABLE();
+
+	TIM17->CR1 = 0;
+	TIM17->PSC = (SystemCoreClock / TICK_HZ) - 1;
+	TIM17->ARR = (TICK_HZ / 1000) * BUTTON_SAMPLE_MS - 1;
+	TIM17->EGR = TIM_EGR_UG;
+	TIM17->SR = 0;
+	TIM17->DIER = TIM_DIER_UIE;
+
+	HAL_NVIC_SetPriority(TIM17_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(TIM17_IRQn);
+}
+
+static void enter(uint8_t new_state) {
+	state = new_state;
+	timer = 0;
+}
+
+static void start_sampling(void) {
+	EXTI->IMR1 &= ~BUTTON_PIN;       // No more edge interrupts until this gesture is finished
+	stable_pressed = 0;
+	same_count = 0;
+	enter(BUTTON_WAIT_PRESS);
+
+	TIM17->CNT = 0;
+	TIM17->CR1 = TIM_CR1_CEN;
+}
+
+static void stop_sampling(void) {
+	TIM17->CR1 = 0;
+	enter(BUTTON_IDLE);
+
+	EXTI->RPR1 = BUTTON_PIN;         // Forget any edges from while it was masked
+	EXTI->IMR1 |= BUTTON_PIN;
+}
+
+// 1 while no gesture is in progress, so TIM17 isn't needed
+uint8_t button_idle(void) {
+	return state == BUTTON_IDLE;
+}
+
+// Called from the PB7 EXTI callback
+void button_edge_isr(void) {
+	if (state == BUTTON_IDLE) start_sampling();
+}
+
+// Called from TIM17_IRQHandler, every BUTTON_SAMPLE_MS while a gesture is in progress
+void button_IRQHandler(void) {
+	if (!(TIM17->SR & TIM_SR_UIF)) return;
+	TIM17->SR = ~TIM_SR_UIF;
+
+	// Debounce: only accept a change once the pin has read the new level for DEBOUNCE_SAMPLES in a row
+	uint8_t pressed = (BUTTON_PORT->IDR & BUTTON_PIN) != 0;
+	uint8_t changed = 0;
+
+	if (pressed != stable_pressed) {
+		if (++same_count >= DEBOUNCE_SAMPLES) {
+			stable_pressed = pressed;
+			same_count = 0;
+			changed = 1;
+		}
+	} else {
+		same_count = 0;
+	}
+
+	timer++;
+
+	switch (state) {
+	case BUTTON_WAIT_PRESS:
+		if (changed && stable_pressed) {
+			enter(BUTTON_PRESSED);
+		} else if (timer > 2 * DEBOUNCE_SAMPLES) {
+			stop_sampling();     // Never settled to pressed, just noise
+		}
+		break;
+
+	case BUTTON_PRESSED:
+		if (changed && !stable_pressed) {
+			enter(BUTTON_WAIT_SECOND);
+		} else if (timer >= LONG_SAMPLES) {
+			event_post(EVENT_BUTTON_LONG, 0);
+			enter(BUTTON_WAIT_RELEASE);
+		}
+		break;
+
+	case BUTTON_WAIT_SECOND:
+		if (changed && stable_pressed) {
+			event_post(EVENT_BUTTON_DOUBLE, 0);
+			enter(BUTTON_WAIT_RELEASE);
+		} else if (timer >= DOUBLE_SAMPLES) {
+			event_post(EVENT_BUTTON_SHORT, 0);
+			stop_sampling();
+		}
+		break;
+
+	case BUTTON_WAIT_RELEASE:
+		if (!stable_pressed) stop_sampling();
+		break;
+
+	default:
+		stop_sampling();
+		break;
+	}
+}
@@ -0,0 +1,159 @@
+/*
+ * clock_governor.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Runs SYSCLK at the full 48 MHz only while there's real work, and at 48 / CLOCK_IDLE_DIV otherwise.
+ * Sleep current scales with the clock, and between frames the core spends most of its time asleep.
+ *
+ *   - Transmission always runs at full speed, because the WS2812 bit timings in pwmData and TIM1's period are
+ *     worked out for 48 MHz. TIM1 is therefore never retuned; it only runs at 48 MHz. The switch is kept out
+ *     of the vsync ISR: frame_scheduler_poll() raises the clock FRAME_CLOCK_LEAD_US before a vsync that has
+ *     a frame to send, and start_frame_transfer() won't start at any other speed.
+ *   - Rendering runs at whatever speed it finds. After a vsync that started a transfer that's full speed. For
+ *     a static scene, where there's nothing to send, it's the reduced clock, which is plenty for a render
+ *     that changes nothing.
+ *   - power_idle() drops to the reduced clock before sleeping, unless a transfer is still going or the last
+ *     render and encode were heavy (CPU time over CLOCK_HEAVY_PERCENT of the frame, not counting the wait for
+ *     the previous transfer). In that case the next CLOCK_HOLD_FRAMES frames stay at full speed so a
+ *     demanding effect doesn't overrun.
+ *
+ * The divider is the HSI's own (HSIDIV). SYSCLK is HSISYS, so the change is immediate and glitch free.
+ * Everything timed from the bus clock is rescaled on each switch without losing its place:
+ *   - TIM14 (us timebase), TIM16 (vsync) and TIM17 (button) all count us, and timebase_retune_timers() moves
+ *     them to the new clock together. Reloading a prescaler throws away the part of a tick it had counted,
+ *     so the switch is made straight after a tick and the few cycles it takes are measured and added back.
+ *     What's left is under a us per switch and doesn't build up, so vsync keeps its rate (50.0 fps) and
+ *     timebase_now_us() stays in step with HAL_GetTick().
+ *   - SysTick: reloaded for 1 ms at the new clock. The part-finished millisecond is carried over, so
+ *     HAL_GetTick() doesn't drift.
+ *   - Flash wait states: 0 at or below 24 MHz, 1 above.
+ *   - SystemCoreClock, for the HAL.
+ * The boot clock goes the same way: the part resets at HSIDIV /4 (12 MHz), and clock_governor_init() and
+ * clock_governor_full() take it to 48 MHz in place of CubeMX's SystemClock_Config(), whose call is turned off
+ * in Light-Array-9.ioc. That keeps HAL_RCC_OscConfig()/ClockConfig() (~1 KB) out of the flash.
+ * The ADC's asynchronous clock (SYSCLK / 16) slows down too. That only stretches the conversion time.
+ */
+
+#include "clock_governor.h"
+#include "timebase.h"
+#include "main.h"
+
+static uint32_t divider = 1;
+static uint8_t hold_frames = 0;
+static uint32_t last_switch_us = 0;
+static struct ClockStats stats;
+
+static uint32_t hsidiv_bits(uint32_t div) {
+	switch (div) {
+	case 2:  return RCC_HSI_DIV2;
+	case 4:  return RCC_HSI_DIV4;
+	case 8:  return RCC_HSI_DIV8;
+	default: return RCC_HSI_DIV1;
+	}
+}
+
+// Every timer clocked from the bus that keeps time across a switch, see timebase_retune_timers()
+static TIM_TypeDef *const timers[] = { TIM14, TIM16, TIM17 };
+static uint32_t target_div;
+
+// Called by timebase_retune_timers() straight after a timer tick
+static void switch_hsidiv(void) {
+	__HAL_RCC_HSI_CONFIG(hsidiv_bits(target_div));
+}
+
+// Reloads SysTick for 1 ms at the new clock, carrying over the part of a millisecond already counted
+static void retune_systick(void) {
+	static uint32_t carry_us = 0;
+
+	uint32_t load = SysTick->LOAD;
+	carry_us += ((load - SysTick->VAL) * 1000) / (load + 1);
+	if (carry_us >= 1000) {
+		carry_us -= 1000;
+		uwTick += uwTickFreq;
+	}
+
+	SysTick->LOAD = (SystemCoreClock / (1000U / uwTickFreq)) - 1;
+	SysTick->VAL = 0;
+}
+
+static void set_divider(uint32_t new_div) {
+	if (new_div == divider) return;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t now = timebase_now_us();
+	if (divider == 1) {
+		stats.full_us += now - last_switch_us;
+	} else {
+		stats.reduced_us += now - last_switch_us;
+	}
+
+	// More wait states before speeding up, fewer only after slowing down
+	uint32_t hclk = HSI_VALUE / new_div;
+	if (hclk > 24000000) {
+		__HAL_FLASH_SET_LATENCY(FLASH_LATENCY_1);
+		while (__HAL_FLASH_GET_LATENCY() != FLASH_LATENCY_1) {}
+	}
+
+	target_div = new_div;
+	timebase_retune_timers(timers, sizeof(timers) / sizeof(timers[0]), hclk, switch_hsidiv);
+	SystemCoreClock = hclk;
+
+	if (hclk <= 24000000) {
+		__HAL_FLASH_SET_LATENCY(FLASH_LATENCY_0);
+	}
+
+	retune_systick();
+
+	divider = new_div;
+	stats.switches++;
+	last_switch_us = timebase_now_us();
+
+	__set_PRIMASK(primask);
+}
+
+// Picks up the divider the part reset with. Call once, after timebase_init() and HAL_Init().
+void clock_governor_init(void) {
+	divider = 1UL << ((RCC->CR & RCC_CR_HSIDIV) >> RCC_CR_HSIDIV_Pos);
+	last_switch_us = timebase_now_us();
+}
+
+// Full speed, for transmission
+void clock_governor_full(void) {
+	set_divider(1);
+}
+
+// Reduced speed, unless a heavy render recently asked for full speed to be held
+// Call with nothing timed off TIM1 in progress.
+void clock_governor_idle(void) {
+	if (hold_frames) return;
+	set_divider(CLOCK_IDLE_DIV);
+}
+
+// Called after each render with the CPU time it took (render and encode, not waiting). Heavy renders hold full speed for a while.
+void clock_governor_report_load(uint32_t busy_us, uint32_t period_us) {
+	// busy_us is measured at the current clock; scale it to what it would be at the reduced clock
+	uint32_t reduced_us = (busy_us / divider) * CLOCK_IDLE_DIV;
+
+	if (reduced_us * 100 > period_us * CLOCK_HEAVY_PERCENT) {
+		hold_frames = CLOCK_HOLD_FRAMES;
+		set_divider(1);
+	} else if (hold_frames) {
+		hold_frames--;
+	}
+}
+
+uint32_t clock_governor_divider(void) {
+	return divider;
+}
+
+void clock_governor_get_stats(struct ClockStats *out) {
+	__disable_irq();
+	*out = stats;
+	__enable_irq();
+}
@@ -0,0 +1,46 @@
+/*
+ * derating.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Works out how far to cap LED brightness (set_output_limit()) from the supply voltage and die temperature.
+ *
+ * A full white frame pulls the supply down and warms the board. Rather than a fixed brightness low enough to
+ * be safe in the worst case, the output runs at full brightness and is only cut back while VDDA sags or the
+ * temperature climbs, by whichever of the two asks for more.
+ *
+ * Cuts take effect immediately, but the limit only creeps back up DERATE_RECOVER_STEP per update. Otherwise
+ * dimming relieves the sag, the sag goes away, full brightness brings it back, and the display pulses.
+ */
+
+#include "derating.h"
+
+static uint8_t limit = 255;
+
+// 255 at or before start, DERATE_FLOOR at or past end, linear in between (works for start > end too)
+static uint8_t ramp(int32_t value, int32_t start, int32_t end) {
+	int32_t span = end - start;
+	int32_t progress = ((value - start) * 256) / span;
+
+	if (progress <= 0) return 255;
+	if (progress >= 256) return DERATE_FLOOR;
+	return 255 - ((progress * (255 - DERATE_FLOOR)) >> 8);
+}
+
+// Returns the new output limit, 0 - 255
+uint8_t derate_update(uint16_t vdda_mv, int16_t temperature) {
+	uint8_t supply  = ramp(vdda_mv, DERATE_VDDA_START_MV, DERATE_VDDA_END_MV);
+	uint8_t thermal = ramp(temperature, DERATE_TEMP_START, DERATE_TEMP_END);
+	uint8_t target  = (supply < thermal) ? supply : thermal;
+
+	if (target < limit) {
+		limit = target;
+	} else if (target > limit) {
+		limit = (target - limit > DERATE_RECOVER_STEP) ? limit + DERATE_RECOVER_STEP : target;
+	}
+
+	return limit;
+}
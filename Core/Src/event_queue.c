@@ -0,0 +1,70 @@
+/*
+ * event_queue.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Lock-free single-producer/single-consumer ring buffer of timestamped events from ISRs to the main loop.
+ * Unlike a volatile flag, several events of the same type between polls are all kept, in order, with
+ * the time each one happened.
+ *
+ *   - Producer: ISRs, through event_post(). Only the producer writes head.
+ *   - Consumer: the main loop, through event_get(). Only the consumer writes tail.
+ *
+ * Every ISR that posts must run at the same NVIC priority (currently 0), so they can't preempt each other
+ * and together behave as a single producer. Posting from an ISR at another priority needs a critical
+ * section in event_post().
+ *
+ * If the queue is full the new event is dropped and counted, never overwriting one not yet read.
+ */
+
+#include "event_queue.h"
+#include "timebase.h"
+#include "main.h"
+
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+_Static_assert((EVENT_QUEUE_SIZE & EVENT_QUEUE_MASK) == 0, "EVENT_QUEUE_SIZE must be a power of 2");
+
+static struct Event queue[EVENT_QUEUE_SIZE];
+static volatile uint8_t head = 0;    // Next slot to write
+static volatile uint8_t tail = 0;    // Next slot to read
+static volatile uint32_t dropped = 0;
+
+// Called from ISRs. Returns 0 if the queue was full and the event was dropped.
+RAMFUNC uint8_t event_post(uint8_t type, uint16_t arg) {
+	uint8_t current = head;
+	uint8_t next = (current + 1) & EVENT_QUEUE_MASK;
+
+	if (next == tail) {
+		dropped++;
+		return 0;
+	}
+
+	queue[current].time_us = timebase_now_us();
+	queue[current].arg = arg;
+	queue[current].type = type;
+
+	__DMB();          // The event must be written before it's published
+	head = next;
+	return 1;
+}
+
+// Called from the main loop. Copies the oldest event into event and returns 1, or returns 0 if there are none.
+uint8_t event_get(struct Event *event) {
+	uint8_t current = tail;
+
+	if (current == head) return 0;
+
+	*event = queue[current];
+
+	__DMB();          // Finish reading the slot before handing it back to the producer
+	tail = (current + 1) & EVENT_QUEUE_MASK;
+	return 1;
+}
+
+uint32_t event_dropped_count(void) {
+	return dropped;
+}
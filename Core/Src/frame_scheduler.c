@@ -0,0 +1,198 @@
+/*
+ * frame_scheduler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Fixed-rate frame scheduler, paced by TIM16.
+ *
+ * Each TIM16 update is a "vsync":
+ *   - the ISR starts transmitting the frame rendered since the previous vsync (if there is one),
+ *     so transmission always starts at the same instant regardless of how long the render took
+ *   - then flags the main loop, where frame_scheduler_poll() calls the render callback and encodes the result
+ *     ready for the next vsync
+ *
+ * So a frame is shown one refresh after it's rendered. If the render for a refresh hasn't finished by the
+ * next vsync, that's counted as an overrun and the LEDs keep the previous frame for another refresh.
+ *
+ * Transmission needs the full 48 MHz clock (clock_governor.c), and switching it takes a few us that the vsync
+ * ISR shouldn't spend. TIM16's compare 1 fires FRAME_CLOCK_LEAD_US before each vsync and, if a frame is
+ * waiting, signals the render task, whose frame_scheduler_poll() raises the clock in time.
+ *
+ * The render callback runs in the main loop, not in the ISR. If a task is set with frame_scheduler_set_task()
+ * it is signalled at each vsync, and should call frame_scheduler_poll().
+ *
+ * Between frames of a static scene the core may go into Stop mode (power.c), which freezes TIM16. It stops
+ * short of the next vsync (frame_scheduler_us_until_vsync()) and frame_scheduler_skip_us() then moves the
+ * counter on by the time spent stopped, so vsyncs stay at the same rate and phase.
+ */
+
+#include "frame_scheduler.h"
+#include "timebase.h"
+#include "scheduler.h"
+#include "clock_governor.h"
+
+#define TICK_HZ TIMEBASE_HZ   // TIM16 counts us, like every timer the clock governor retunes; FRAME_RATE_MIN fps fits
+#define TICK_US (1000000 / TICK_HZ)
+
+static struct Colour *render_frame;
+static FrameRenderCallback render_callback;
+static uint8_t vsync_task;
+static uint8_t vsync_task_set = 0;
+
+static volatile uint8_t  vsync_pending = 0;   // Set by the ISR, render due
+static volatile uint8_t  rendering = 0;       // Set while the main loop is rendering/encoding
+static volatile uint8_t  frame_ready = 0;     // An encoded frame is waiting for the next vsync
+static volatile uint32_t vsync_time_us;
+static volatile uint32_t vsync_tick;
+
+static struct FrameStats stats;
+
+void frame_scheduler_init(struct Colour *frame, FrameRenderCallback render, uint16_t fps) {
+	render_frame = frame;
+	render_callback = render;
+
+	__HAL_RCC_TIM16_CLK_ENABLE();
+
+	TIM16->CR1 = 0;
+	TIM16->PSC = (SystemCoreClock / TICK_HZ) - 1;
+	frame_scheduler_set_fps(fps);
+	TIM16->EGR = TIM_EGR_UG;       // Load the prescaler now
+	TIM16->SR = 0;
+	TIM16->DIER = TIM_DIER_UIE | TIM_DIER_CC1IE;   // Compare 1 is the clock raise, see frame_scheduler_poll()
+
+	frame_scheduler_reset_stats();
+
+	// Below the transmit DMA (priority 0) so the DMA complete callback is never held up by a vsync
+	HAL_NVIC_SetPriority(TIM16_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(TIM16_IRQn);
+
+	TIM16->CR1 = TIM_CR1_CEN;
+}
+
+// Takes effect from the next vsync
+void frame_scheduler_set_fps(uint16_t fps) {
+	if (fps < FRAME_RATE_MIN) fps = FRAME_RATE_MIN;
+	if (fps > FRAME_RATE_MAX) fps = FRAME_RATE_MAX;
+
+	TIM16->ARR = (TICK_HZ / fps) - 1;
+	TIM16->CCR1 = TIM16->ARR + 1 - FRAME_CLOCK_LEAD_US / TICK_US;
+	stats.period_us = (1000000UL / TICK_HZ) * (TIM16->ARR + 1);
+}
+
+// Signals task_id (see scheduler.c) at each vsync
+void frame_scheduler_set_task(uint8_t task_id) {
+	vsync_task = task_id;
+	vsync_task_set = 1;
+}
+
+// 1 while an encoded frame is waiting for the next vsync
+uint8_t frame_scheduler_frame_waiting(void) {
+	return frame_ready;
+}
+
+// 1 from FRAME_CLOCK_LEAD_US before a vsync that has a frame to send, when the clock has to be at full speed
+uint8_t frame_scheduler_clock_due(void) {
+	return frame_ready && frame_scheduler_us_until_vsync() <= FRAME_CLOCK_LEAD_US;
+}
+
+// Call from the main loop as often as possible, or from the task set with frame_scheduler_set_task()
+// Renders and encodes the next frame if a vsync has happened since the last call. Returns 1 if it did.
+// Also raises the clock ahead of a vsync with a frame to send. TIM16's compare 1 signals the task for that,
+// so the vsync ISR itself never has to switch the clock.
+uint8_t frame_scheduler_poll(void) {
+	if (frame_scheduler_clock_due()) clock_governor_full();
+	if (!vsync_pending) return 0;
+
+	rendering = 1;
+	vsync_pending = 0;
+
+	// CPU time only, for the clock governor. The wait for the transfer this vsync started is left out.
+	uint32_t start = timebase_now_us();
+	uint32_t busy_us;
+
+	if (render_callback(render_frame, vsync_tick)) {
+		busy_us = timebase_elapsed_us(start);
+		wait_for_frame_sent();
+		start = timebase_now_us();
+		encode_frame(render_frame);
+		busy_us += timebase_elapsed_us(start);
+		frame_ready = 1;
+		if (frame_scheduler_clock_due()) clock_governor_full();    // The render ran into the lead time
+	} else {
+		busy_us = timebase_elapsed_us(start);
+	}
+
+	rendering = 0;
+
+	stats.last_render_us = timebase_elapsed_us(vsync_time_us);
+	if (stats.last_render_us > stats.max_render_us) stats.max_render_us = stats.last_render_us;
+
+	clock_governor_report_load(busy_us, stats.period_us);
+
+	return 1;
+}
+
+// Time left until the next vsync
+uint32_t frame_scheduler_us_until_vsync(void) {
+	return (TIM16->ARR - TIM16->CNT) * TICK_US;
+}
+
+// Moves TIM16 on by time that passed while it was stopped. Call with interrupts disabled.
+void frame_scheduler_skip_us(uint32_t us) {
+	static uint32_t remainder_us = 0;
+
+	us += remainder_us;
+	remainder_us = us % TICK_US;
+
+	uint32_t count = TIM16->CNT + us / TICK_US;
+	if (count > TIM16->ARR) count = TIM16->ARR;    // Overslept, vsync on the next tick rather than never
+	TIM16->CNT = count;
+}
+
+void frame_scheduler_get_stats(struct FrameStats *out) {
+	__disable_irq();
+	*out = stats;
+	__enable_irq();
+}
+
+void frame_scheduler_reset_stats(void) {
+	stats.frames = 0;
+	stats.overruns = 0;
+	stats.last_render_us = 0;
+	stats.max_render_us = 0;
+}
+
+// Called from TIM16_IRQHandler
+void frame_scheduler_IRQHandler(void) {
+	if (TIM16->SR & TIM_SR_CC1IF) {
+		TIM16->SR = ~TIM_SR_CC1IF;
+		if (frame_ready && vsync_task_set) scheduler_signal(vsync_task);   // Time to raise the clock
+	}
+
+	if (!(TIM16->SR & TIM_SR_UIF)) return;
+	TIM16->SR = ~TIM_SR_UIF;
+
+	if (rendering || vsync_pending) {
+		// Last render hasn't finished (or hasn't even started), keep showing the previous frame
+		stats.overruns++;
+		return;
+	}
+
+	if (frame_ready) {
+		if (start_frame_transfer()) {
+			frame_ready = 0;
+			stats.frames++;
+		} else {
+			stats.overruns++;     // Clock not raised in time, the frame goes at the next vsync instead
+		}
+	}
+
+	vsync_time_us = timebase_now_us();
+	vsync_tick = HAL_GetTick();
+	vsync_pending = 1;
+
+	if (vsync_task_set) scheduler_signal(vsync_task);
+}
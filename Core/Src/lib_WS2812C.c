@@ -24,10 +24,21 @@
  *
  */
 
+#include <string.h>
 #include "lib_WS2812C.h"
 #include "main.h"
+#include "stm32c0xx_ll_dma.h"
+#include "stm32c0xx_ll_tim.h"
+#include "event_queue.h"
+#include "power.h"
+#include "clock_governor.h"
+#include "timebase.h"
 
-volatile uint8_t FLAG_DataSent = 0;
+volatile uint8_t FLAG_DataSent = 1;   // 1 while no transfer is in progress
+
+static uint8_t brightness = 255;     // Brightness asked for, 255 = full
+static uint8_t output_limit = 255;   // Ceiling imposed by derating, 255 = none
+static uint8_t scale = 255;          // brightness limited by output_limit, applied while encoding
 
 
 // A function that returns an instance of a Colour struct with defined RGB values
@@ -115,196 +126,183 @@ void set_colour_LED(struct Colour *frame, uint32_t LED_number, struct Colour des
 	frame[LED_number] = desired_colour;
 }
 
-void send_frame(struct Colour *frame) {
+static uint16_t pwmData[PWM_BUFFER_LENGTH] ENCODE_BUFFER;  // 24  = 24 bits of colour data for each LED
+                                                           // 600 = 300 zeros before and after actual data to hold data line low
+                                                           //       needed for timing requirements
+                                                           // Not zeroed at startup, nothing is sent until a frame is encoded
 
-	static uint16_t pwmData[(24*NUM_LEDS)+600];  // 24  = 24 bits of colour data for each LED
-	                                             // 600 = 300 zeros before and after actual data to hold data line low
-	                                             //       needed for timing requirements
+// Counts the Colour frame and pwmData
+_Static_assert(LED_RAM_BYTES <= LED_RAM_BUDGET, "NUM_LEDS needs more RAM than LED_RAM_BUDGET, see Tools/ram_report.py");
 
-	uint32_t index = 0;    // Keeps track of our current place writing data to pwmData
-
-	// Set first 300 elements of pwmData to 0% duty cycles to keep line low for the latch command (reset LEDs)
+// Writes 300 elements of 0% duty cycles starting at index to keep line low for the latch command (reset LEDs)
+// Returns the index just past the written latch
+RAMFUNC static uint32_t write_latch(uint32_t index) {
 	for (uint16_t i = 0; i < 300; i++) {
 		pwmData[index] = 0;
 		index++;
 	}
+	return index;
+}
+
+// Converts a colour into the 24 duty cycles that represent it on the data line (GRB order, MSB first)
+RAMFUNC static void encode_colour(uint16_t *dest, struct Colour colour) {
 
 	uint32_t color;      // color data is 24 bits. Will hold all the RGB bits.
 
-	for (uint32_t LED = 0; LED < NUM_LEDS; LED++) {     // for each LED
+	if (scale != 255) {
+		colour.Red   = ((uint16_t)colour.Red   * (scale + 1)) >> 8;
+		colour.Green = ((uint16_t)colour.Green * (scale + 1)) >> 8;
+		colour.Blue  = ((uint16_t)colour.Blue  * (scale + 1)) >> 8;
+	}
+
+	// Concatenate color values into a single string
+	color = (((uint32_t)colour.Green << 16) |
+			 ((uint32_t)colour.Red   << 8 ) |
+			 ((uint32_t)colour.Blue));
 
-		// Concatenate color values into a single string
-		color = (((uint32_t)frame[LED].Green << 16) |
-				 ((uint32_t)frame[LED].Red   << 8 ) |
-				 ((uint32_t)frame[LED].Blue));
-
-		for (int bit = 23; bit >= 0; bit--) {    // for each bit of color values
-			if (color & (1 << bit)) {
-				pwmData[index] = 30;   // 50% duty cycle
-			} else {
-				pwmData[index] = 15;   // 25% duty cycle
-			}
-			index++;
+	for (int bit = 23; bit >= 0; bit--) {    // for each bit of color values
+		if (color & (1 << bit)) {
+			*dest = 30;   // 50% duty cycle
+		} else {
+			*dest = 15;   // 25% duty cycle
 		}
+		dest++;
 	}
+}
 
-	// send a bunch of 0% duty cycles to keep line low for the latch command
-	for (uint16_t i = 0; i < 300; i++) {
-		pwmData[index] = 0;
-		index++;
-	}
+static uint32_t pwm_length = 0;   // Elements of pwmData holding the last encoded frame
+static uint32_t encode_cycles = 0;
 
-	// Start DMA and wait until it's done
-	HAL_TIM_PWM_Start_DMA(&htim1, TIM_CHANNEL_1, (uint32_t*) pwmData, index);
-	while (!FLAG_DataSent) {};
-	FLAG_DataSent = 0;
+// Encodes a frame into pwmData without sending it
+// Waits for any transfer that's still reading pwmData first
+RAMFUNC void encode_frame(struct Colour *frame) {
 
-}
+	uint32_t index = 0;    // Keeps track of our current place writing data to pwmData
 
-void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
-	FLAG_DataSent = 1;
-}
+	wait_for_frame_sent();
 
-// Predefined colours
-//                              R    G    B
-const struct Colour Red    = {255,   0,   0};
-const struct Colour Green  = {  0, 255,   0};
-const struct Colour Blue   = {  0,   0, 255};
-const struct Colour Yellow = {255,  90,   0};
-const struct Colour Purple = {255,   0, 150};
-const struct Colour Cyan   = {  0, 255, 255};
-const struct Colour White  = {255, 100, 100};
-const struct Colour Black  = {  0,   0,   0};
+	uint32_t start = timebase_now_us();
 
+	index = write_latch(index);
 
-// Patterns
-// Should be able to remove this section of the library
-// In other words, nothing here should be core functionality
+	for (uint32_t LED = 0; LED < NUM_LEDS; LED++) {     // for each LED
+		encode_colour(&pwmData[index], frame[LED]);
+		index += 24;
+	}
 
-void Pattern_cycle_RGB(struct Colour *frame) {
-	while (1) {
-		set_colour_whole_frame(frame, Red);
-		send_frame(frame);
-		if (FLAG_BTN) return;
-		HAL_Delay(500);
+	// send a bunch of 0% duty cycles to keep line low for the latch command
+	index = write_latch(index);
 
-		set_colour_whole_frame(frame, Green);
-		send_frame(frame);
-		if (FLAG_BTN) return;
-		HAL_Delay(500);
+	pwm_length = index;
+	encode_cycles = timebase_elapsed_us(start) * (SystemCoreClock / 1000000);
+}
 
-		set_colour_whole_frame(frame, Blue);
-		send_frame(frame);
-		if (FLAG_BTN) return;
-		HAL_Delay(500);
-	}
+// CPU cycles the last encode took, not counting the wait for the previous transfer.
+// Timed on the us timebase, so to within one us (48 cycles at full speed).
+uint32_t get_encode_cycles(void) {
+	return encode_cycles;
 }
 
+// One-off set up of the transmit path, after the TIM1 MSP init (clock, pin and DMA channel). MX_TIM1_Init()
+// isn't called, TIM1 is set up here at register level, which keeps HAL_TIM (~1.8 KB) out of the flash.
+// TIM1 and DMA1 channel 1 are left configured and running, so starting a frame is just reloading the DMA count
+// and address (start_frame_transfer()).
+//   - TIM1 CH1 free-runs its 1.25 us PWM period (60 ticks at 48 MHz) with CCR1 = 0 (line held low) between frames
+//   - its CC1 DMA request is always on; the DMA channel being disabled is what stops transfers
+//   - DMA1 channel 1 (direction, sizes, DMAMUX request) was set up by HAL_TIM_Base_MspInit, only the
+//     peripheral address is added here
+void init_frame_transfer(void) {
+	LL_TIM_SetPrescaler(TIM1, 0);
+	LL_TIM_SetAutoReload(TIM1, 60 - 1);
+	LL_TIM_OC_SetMode(TIM1, LL_TIM_CHANNEL_CH1, LL_TIM_OCMODE_PWM1);
+	LL_TIM_OC_EnablePreload(TIM1, LL_TIM_CHANNEL_CH1);
+	LL_TIM_OC_SetCompareCH1(TIM1, 0);
+	LL_TIM_GenerateEvent_UPDATE(TIM1);     // Loads the prescaler and CCR1 preload, as HAL_TIM_Base_Init() would
+	LL_TIM_CC_EnableChannel(TIM1, LL_TIM_CHANNEL_CH1);
+	LL_TIM_EnableAllOutputs(TIM1);
+	LL_TIM_EnableDMAReq_CC1(TIM1);
+	LL_TIM_EnableCounter(TIM1);
+
+	LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_1);
+	LL_DMA_SetPeriphAddress(DMA1, LL_DMA_CHANNEL_1, (uint32_t)&TIM1->CCR1);
+	LL_DMA_ClearFlag_GI1(DMA1);
+	LL_DMA_EnableIT_TC(DMA1, LL_DMA_CHANNEL_1);
+	LL_DMA_EnableIT_TE(DMA1, LL_DMA_CHANNEL_1);
+}
 
+// Starts DMA of the last encoded frame and returns straight away. Safe to call from an ISR.
+// Returns 0 and does nothing if a transfer is already in progress, or if the clock isn't at the full 48 MHz
+// the bit timings are worked out for (see clock_governor_full()).
+uint8_t start_frame_transfer(void) {
+	if (!FLAG_DataSent || pwm_length == 0 || clock_governor_divider() != 1) return 0;
 
-// implements a rainbow gradient as per
-// https://en.wikipedia.org/wiki/HSL_and_HSV#/media/File:HSV-RGB-comparison.svg
-void Pattern_RainbowGradient(struct Colour *frame) {
-	while (1) {
+	FLAG_DataSent = 0;
 
-		uint32_t delay = 2;
+	LL_DMA_SetMemoryAddress(DMA1, LL_DMA_CHANNEL_1, (uint32_t)pwmData);
+	LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_1, pwm_length);
+	LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_1);
+	return 1;
+}
 
-		// All red as starting point
-		struct Colour current_colour = { .Red = 255, .Green = 0, .Blue = 0 };
-		set_colour_whole_frame(frame, current_colour);
-		send_frame(frame);
+uint8_t frame_transfer_busy(void) {
+	return !FLAG_DataSent;
+}
 
-		// R max, G increasing
-		current_colour.Red = 255;
-		current_colour.Blue = 0;
-		for (int i = 0; i < 256; i++) {
-			current_colour.Green = i;
-			set_colour_whole_frame(frame, current_colour);
-			send_frame(frame);
-			HAL_Delay(delay);
-			if (FLAG_BTN) return;
-		}
+void wait_for_frame_sent(void) {
+	power_wait_for(&FLAG_DataSent);
+}
 
-		// G max, R decreasing
-		current_colour.Green = 255;
-		current_colour.Blue = 0;
-		for (int i = 0; i < 256; i++) {
-			current_colour.Red = 255 - i;
-			set_colour_whole_frame(frame, current_colour);
-			send_frame(frame);
-			HAL_Delay(delay);
-			if (FLAG_BTN) return;
-		}
+// Encode, start DMA and wait until it's done
+void send_frame(struct Colour *frame) {
+	encode_frame(frame);
+	clock_governor_full();
+	start_frame_transfer();
+	wait_for_frame_sent();
+}
 
-		// G max, B increasing
-		current_colour.Red = 0;
-		current_colour.Green = 255;
-		for (int i = 0; i < 256; i++) {
-			current_colour.Blue = i;
-			set_colour_whole_frame(frame, current_colour);
-			send_frame(frame);
-			HAL_Delay(delay);
-			if (FLAG_BTN) return;
-		}
+// Called from DMA1_Channel1_IRQHandler, when the whole frame (and the reset latch after it) has gone out
+RAMFUNC void frame_transfer_IRQHandler(void) {
+	LL_DMA_ClearFlag_GI1(DMA1);      // Transfer complete, or a transfer error, either way it's over
+	LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_1);
 
-		// B max, G decreasing
-		current_colour.Red = 0;
-		current_colour.Blue = 255;
-		for (int i = 0; i < 256; i++) {
-			current_colour.Green = 255 - i;
-			set_colour_whole_frame(frame, current_colour);
-			send_frame(frame);
-			HAL_Delay(delay);
-			if (FLAG_BTN) return;
-		}
+	FLAG_DataSent = 1;
+	event_post(EVENT_FRAME_SENT, 0);
+}
 
-		// B max, R increasing
-		current_colour.Green = 0;
-		current_colour.Blue = 255;
-		for (int i = 0; i < 256; i++) {
-			current_colour.Red = i;
-			set_colour_whole_frame(frame, current_colour);
-			send_frame(frame);
-			HAL_Delay(delay);
-			if (FLAG_BTN) return;
-		}
 
-		// R max, B decreasing
-		current_colour.Red = 255;
-		current_colour.Green = 0;
-		for (int i = 0; i < 256; i++) {
-			current_colour.Blue = 255 - i;
-			set_colour_whole_frame(frame, current_colour);
-			send_frame(frame);
-			HAL_Delay(delay);
-			if (FLAG_BTN) return;
-		}
-	}
+static void update_scale(void) {
+	scale = ((uint16_t)brightness * (output_limit + 1)) >> 8;
 }
 
-/*
-// !TODO Rewrite with new functions
-void Pattern_RainbowGradientDiag(void) {
-	while (1) {
-		for (uint16_t i = 0; i < 1536; i++) {
-			HuetoRGB(2, i + 160);
+// Scales every colour sent from now on by (level + 1) / 256. Frames keep their full colour values.
+void set_brightness(uint8_t level) {
+	brightness = level;
+	update_scale();
+}
 
-			HuetoRGB(1, i + 120);
-			HuetoRGB(5, i + 120);
+uint8_t get_brightness(void) {
+	return brightness;
+}
 
-			HuetoRGB(0, i + 80);
-			HuetoRGB(4, i + 80);
-			HuetoRGB(8, i + 80);
+// Caps the brightness at (limit + 1) / 256 of whatever set_brightness() asked for, for derating
+void set_output_limit(uint8_t limit) {
+	output_limit = limit;
+	update_scale();
+}
 
-			HuetoRGB(3, i + 40);
-			HuetoRGB(7, i + 40);
+uint8_t get_output_limit(void) {
+	return output_limit;
+}
 
-			HuetoRGB(6, i);
 
-			WS2812C_Send();
-			HAL_Delay(20);
+// Predefined colours
+//                              R    G    B
+const struct Colour Red    = {255,   0,   0};
+const struct Colour Green  = {  0, 255,   0};
+const struct Colour Blue   = {  0,   0, 255};
+const struct Colour Yellow = {255,  90,   0};
+const struct Colour Purple = {255,   0, 150};
+const struct Colour Cyan   = {  0, 255, 255};
+const struct Colour White  = {255, 100, 100};
+const struct Colour Black  = {  0,   0,   0};
 
-		}
-	}
-}
-*/
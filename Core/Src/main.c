@@ -23,6 +23,17 @@
 /* USER CODE BEGIN Includes */
 
 #include "lib_WS2812C.h"
+#include "patterns.h"
+#include "timebase.h"
+#include "frame_scheduler.h"
+#include "scheduler.h"
+#include "event_queue.h"
+#include "button.h"
+#include "adc_input.h"
+#include "derating.h"
+#include "power.h"
+#include "clock_governor.h"
+#include "settings.h"
 
 /* USER CODE END Includes */
 
@@ -43,15 +54,47 @@
 
 /* Private variables ---------------------------------------------------------*/
 ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;
 
 TIM_HandleTypeDef htim1;
 DMA_HandleTypeDef hdma_tim1_ch1;
 
 /* USER CODE BEGIN PV */
 
-volatile uint8_t FLAG_BTN = 0;
-
-volatile uint32_t value_adc = 0;
+static struct Colour frame[NUM_LEDS] FRAME_BUFFER;   // Not zeroed at startup, cleared in main()
+
+static uint8_t render_task;
+static uint8_t standby = 0;             // Output blanked by a long press
+static uint8_t output_limit_changed = 0;   // Derating moved, the frame needs encoding again even if unchanged
+static uint8_t unchanged_frames = 0;       // Renders in a row that left the frame as it was
+
+// Milestones of the last boot, in us from entering main() (the startup code before it isn't counted)
+struct BootTimes {
+	uint32_t clock_us;         // System clock at 48 MHz
+	uint32_t black_us;         // Black frame starting to go out, the LEDs lose whatever they powered up showing
+	uint32_t latched_us;       // Black frame and its reset latch sent
+	uint32_t scene_us;         // Restored pattern's first frame starting to go out
+	uint32_t ready_us;         // Entering the main loop
+};
+
+// Runtime statistics, mostly snapshotted by the telemetry task. Watch it in the debugger (Live Expressions).
+struct Telemetry {
+	struct FrameStats frame;
+	uint32_t button_presses;
+	uint32_t frames_sent;
+	uint32_t control_changes;
+	uint16_t vdda_mv;
+	int16_t temperature;
+	uint8_t output_limit;
+	struct PowerStats power;
+	struct ClockStats clock;
+	struct SettingsStats settings;
+	uint8_t cpu_load;          // % of the last telemetry period spent awake
+	uint32_t encode_cycles;    // Worst frame encode seen, in CPU cycles
+	uint32_t events_dropped;
+};
+volatile struct Telemetry telemetry;
+volatile struct BootTimes boot;
 
 /* USER CODE END PV */
 
@@ -62,6 +105,12 @@ static void MX_DMA_Init(void);
 static void MX_TIM1_Init(void);
 static void MX_ADC1_Init(void);
 /* USER CODE BEGIN PFP */
+static uint8_t render(struct Colour *frame, uint32_t now);
+static void task_render(uint32_t now);
+static void task_adc(uint32_t now);
+static void task_derate(uint32_t now);
+static void task_telemetry(uint32_t now);
+static void task_settings(uint32_t now);
 
 /* USER CODE END PFP */
 
@@ -79,6 +128,9 @@ int main(void)
 
   /* USER CODE BEGIN 1 */
 
+  // Started first, at the 12 MHz reset clock, so the boot can be timed from here
+  timebase_init();
+
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -90,61 +142,73 @@ int main(void)
 
   /* USER CODE END Init */
 
-  /* Configure the system clock */
-  SystemClock_Config();
-
   /* USER CODE BEGIN SysInit */
 
+  // Up to 48 MHz from the 12 MHz reset clock, see clock_governor.c
+  clock_governor_init();
+  clock_governor_full();
+  boot.clock_us = timebase_now_us();
+
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_DMA_Init();
-  MX_TIM1_Init();
-  MX_ADC1_Init();
   /* USER CODE BEGIN 2 */
 
+  // MX_TIM1_Init() isn't called (see the .ioc), init_frame_transfer() sets TIM1 up at register level.
+  // The generated MSP code still enables its clock and sets up its pin and DMA channel.
+  (void)MX_TIM1_Init;
+  htim1.Instance = TIM1;
+  HAL_TIM_Base_MspInit(&htim1);
+  HAL_TIM_MspPostInit(&htim1);
 
-  struct Colour frame[NUM_LEDS];
+  // Fast path: latch black as soon as TIM1 and the DMA can send it, before anything that waits or can be put off.
+  // The frame goes out in the background (~1 ms for 9 LEDs) while the rest of the init runs.
+  init_frame_transfer();
   clear_frame(frame);
+  encode_frame(frame);
+  start_frame_transfer();
+  boot.black_us = timebase_now_us();
 
-  HAL_ADCEx_Calibration_Start(&hadc1);
-
-  // !TODO Written by ChatGPT. Read through and understand/rewrite if needed.
-  uint8_t Read_ADC(void)
-  {
-      HAL_ADC_Start(&hadc1);
-      HAL_ADC_PollForConversion(&hadc1, 10);
-      uint8_t val = HAL_ADC_GetValue(&hadc1);
-      HAL_ADC_Stop(&hadc1);
-      return val;
-  }
-
-  /* USER CODE END 2 */
+  power_init();
+  button_init();
 
-  /* Infinite loop */
-  /* USER CODE BEGIN WHILE */
-	while (1) {
+  // ADC init and calibration are deferred to here, the pot isn't needed until the first render
+  MX_ADC1_Init();
+  adc_input_start();
 
-		set_colour_whole_frame(frame, Cyan);
-		send_frame(frame);
+  // Pick up where the last power cycle left off
+  uint32_t saved;
+  settings_init();
+  pattern_select(settings_get(SETTING_PATTERN, &saved) ? saved : 0, frame, HAL_GetTick());
+  if (settings_get(SETTING_BRIGHTNESS, &saved)) set_brightness(saved);
+  if (settings_get(SETTING_SPEED, &saved)) pattern_set_speed(saved);
+  send_frame(frame);     // Waits for the black frame first
+  boot.scene_us = timebase_now_us();
 
-		HAL_Delay(Read_ADC()*10);
+  // Tasks, see scheduler.c
+  render_task = scheduler_add_task(task_render,    0,    PRIORITY_RENDER);    // Signalled at each vsync
+  adc_input_set_task(scheduler_add_task(task_adc, 0, PRIORITY_ADC));          // Signalled by the ADC interrupts
+  scheduler_add_task(task_derate,    DERATE_PERIOD_MS, PRIORITY_DERATE);
+  scheduler_add_task(task_telemetry, 1000, PRIORITY_TELEMETRY);
+  scheduler_add_task(task_settings,  SETTINGS_PERIOD_MS, PRIORITY_SETTINGS);
 
-		set_colour_whole_frame(frame, Blue);
-		send_frame(frame);
+  frame_scheduler_init(frame, render, FRAME_RATE_DEFAULT);
+  frame_scheduler_set_task(render_task);
 
-		HAL_Delay(Read_ADC()*10);
+  boot.ready_us = timebase_now_us();
 
-		/*
-		Pattern_RainbowGradient(frame);
-		FLAG_BTN = 0;
+  /* USER CODE END 2 */
 
-		Pattern_cycle_RGB(frame);
-		FLAG_BTN = 0;
-		// !TODO Create custom delay function that checks for FLAG_BTN?
-		*/
+  /* Infinite loop */
+  /* USER CODE BEGIN WHILE */
+	// Everything from here on happens in tasks, sleeping whenever none are ready
+	while (1) {
 
+		if (!scheduler_run()) {
+			power_idle();
+		}
 
     /* USER CODE END WHILE */
 
@@ -213,22 +277,25 @@ static void MX_ADC1_Init(void)
   */
   hadc1.Instance = ADC1;
   hadc1.Init.ClockPrescaler = ADC_CLOCK_ASYNC_DIV16;
-  hadc1.Init.Resolution = ADC_RESOLUTION_8B;
+  hadc1.Init.Resolution = ADC_RESOLUTION_12B;
   hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-  hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
+  hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
   hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
   hadc1.Init.LowPowerAutoWait = DISABLE;
   hadc1.Init.LowPowerAutoPowerOff = DISABLE;
-  hadc1.Init.ContinuousConvMode = DISABLE;
-  hadc1.Init.NbrOfConversion = 1;
+  hadc1.Init.ContinuousConvMode = ENABLE;
+  hadc1.Init.NbrOfConversion = 3;
   hadc1.Init.DiscontinuousConvMode = DISABLE;
   hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
   hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
-  hadc1.Init.DMAContinuousRequests = DISABLE;
-  hadc1.Init.Overrun = ADC_OVR_DATA_PRESERVED;
-  hadc1.Init.SamplingTimeCommon1 = ADC_SAMPLETIME_1CYCLE_5;
+  hadc1.Init.DMAContinuousRequests = ENABLE;
+  hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+  hadc1.Init.SamplingTimeCommon1 = ADC_SAMPLETIME_39CYCLES_5;
   hadc1.Init.SamplingTimeCommon2 = ADC_SAMPLETIME_1CYCLE_5;
-  hadc1.Init.OversamplingMode = DISABLE;
+  hadc1.Init.OversamplingMode = ENABLE;
+  hadc1.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_16;
+  hadc1.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_4;
+  hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
   hadc1.Init.TriggerFrequencyMode = ADC_TRIGGER_FREQ_HIGH;
   if (HAL_ADC_Init(&hadc1) != HAL_OK)
   {
@@ -244,6 +311,24 @@ static void MX_ADC1_Init(void)
   {
     Error_Handler();
   }
+
+  /** Configure Regular Channel
+  */
+  sConfig.Channel = ADC_CHANNEL_VREFINT;
+  sConfig.Rank = ADC_REGULAR_RANK_2;
+  if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /** Configure Regular Channel
+  */
+  sConfig.Channel = ADC_CHANNEL_TEMPSENSOR;
+  sConfig.Rank = ADC_REGULAR_RANK_3;
+  if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE BEGIN ADC1_Init 2 */
 
   /* USER CODE END ADC1_Init 2 */
@@ -345,6 +430,9 @@ static void MX_DMA_Init(void)
   /* DMA1_Channel1_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+  /* DMA1_Channel2_3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
 
 }
 
@@ -381,12 +469,140 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 
+// Called by the frame scheduler once per refresh, see frame_scheduler.c
+// Handles every event posted by the ISRs since the last frame, then steps the active pattern.
+// Returns 1 if the frame changed.
+static uint8_t render(struct Colour *frame, uint32_t now) {
+
+	uint8_t changed = output_limit_changed;
+	struct Event event;
+
+	output_limit_changed = 0;
+
+	while (event_get(&event)) {
+		switch (event.type) {
+		case EVENT_BUTTON_SHORT:
+			if (!standby) pattern_next(frame, now);
+			changed = 1;
+			telemetry.button_presses++;
+			break;
+		case EVENT_BUTTON_DOUBLE:
+			if (!standby) pattern_previous(frame, now);
+			changed = 1;
+			telemetry.button_presses++;
+			break;
+		case EVENT_BUTTON_LONG:
+			// Long press toggles standby: blank the LEDs, or restart the pattern that was showing
+			standby = !standby;
+			if (standby) {
+				clear_frame(frame);
+			} else {
+				pattern_select(pattern_current(), frame, now);
+			}
+			changed = 1;
+			telemetry.button_presses++;
+			break;
+		case EVENT_FRAME_SENT:
+			if (telemetry.frames_sent == 0) boot.latched_us = event.time_us;   // The black frame
+			telemetry.frames_sent++;
+			break;
+		case EVENT_CONTROL_CHANGED:
+			pattern_set_control(event.arg, adc_input_full_scale());
+			telemetry.control_changes++;
+			break;
+		}
+	}
+
+	if (!standby) {
+		changed |= pattern_step(frame, now);
+	}
+
+	// A scene that has sat still for a while lets the core stop between frames (power.c),
+	// and the settings store erase a page, which stalls the CPU for longer than a frame (settings.c)
+	if (changed) {
+		unchanged_frames = 0;
+	} else if (unchanged_frames < POWER_STATIC_FRAMES) {
+		unchanged_frames++;
+	}
+	power_allow_stop(unchanged_frames >= POWER_STATIC_FRAMES);
+	settings_allow_erase(unchanged_frames >= POWER_STATIC_FRAMES);
+
+	return changed;
+}
+
+static void task_render(uint32_t now) {
+	frame_scheduler_poll();
+}
+
+// Switches the ADC between tracking the pot and watching it, see adc_input.c
+static void task_adc(uint32_t now) {
+	adc_input_task();
+}
+
+// Caps the LED brightness while the supply sags or the chip is hot, see derating.c
+static void task_derate(uint32_t now) {
+	uint16_t vdda_mv = adc_input_vdda_mv();
+	int16_t temperature = adc_input_temperature();
+	uint8_t limit = derate_update(vdda_mv, temperature);
+
+	if (limit != get_output_limit()) {
+		set_output_limit(limit);
+		output_limit_changed = 1;
+	}
+
+	telemetry.vdda_mv = vdda_mv;
+	telemetry.temperature = temperature;
+	telemetry.output_limit = limit;
+
+	adc_input_refresh();    // Fresh readings for next time, if the ADC has gone over to the watchdog
+}
+
+static void task_telemetry(uint32_t now) {
+	static uint32_t last_us, last_asleep_us;
+
+	struct FrameStats stats;
+	frame_scheduler_get_stats(&stats);
+	telemetry.frame = stats;
+	telemetry.events_dropped = event_dropped_count();
+
+	uint32_t encode_cycles = get_encode_cycles();
+	if (encode_cycles > telemetry.encode_cycles) telemetry.encode_cycles = encode_cycles;
+
+	struct PowerStats power;
+	power_get_stats(&power);
+	telemetry.power = power;
+
+	struct ClockStats clock;
+	clock_governor_get_stats(&clock);
+	telemetry.clock = clock;
+
+	struct SettingsStats settings;
+	settings_get_stats(&settings);
+	telemetry.settings = settings;
+
+	uint32_t now_us = timebase_now_us();
+	uint32_t asleep_us = power.sleep_us + power.stop_us;
+	uint32_t period_us = now_us - last_us;
+	if (period_us) {
+		telemetry.cpu_load = 100 - ((asleep_us - last_asleep_us) * 100) / period_us;   // Fine for periods up to ~40 s
+	}
+	last_us = now_us;
+	last_asleep_us = asleep_us;
+}
+
+// Hands the current choices to the settings store, which saves them once they've settled (see settings.c)
+static void task_settings(uint32_t now) {
+	settings_set(SETTING_PATTERN, pattern_current());
+	settings_set(SETTING_BRIGHTNESS, get_brightness());
+	settings_set(SETTING_SPEED, pattern_get_speed());
+	settings_task(now);
+}
 
 // Code that triggers when the button interrupt happens
 void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin) {
 
 	if (GPIO_Pin == GPIO_PIN_7) {
-		FLAG_BTN = 1;
+		button_edge_isr();
 	} else {
 		__NOP();
 	}
@@ -0,0 +1,300 @@
+/*
+ * patterns.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * The pattern registry is the only place that needs to change to add a pattern:
+ *   - write its state struct, init and step functions below
+ *   - add a PATTERN_ENABLE_ switch in patterns.h
+ *   - add an entry to pattern_registry[]
+ * The button walks through the registry in order and the pot controls the active pattern's speed.
+ */
+
+#include <string.h>
+#include "patterns.h"
+#include "anim_clock.h"
+#include "anim_stream.h"
+#include "animations.h"
+
+// Each pattern keeps its progress in its own state struct, stored in pattern_state while it's active.
+// Patterns work out what to show from a phase driven by elapsed time (see anim_clock.c), not by counting
+// steps, so they run at the same speed however often they're stepped.
+
+struct Pattern_cycle_RGB_State {
+	struct AnimPhase anim;
+	uint8_t  colour_index;    // 0 = Red, 1 = Green, 2 = Blue
+};
+
+struct Pattern_RainbowGradient_State {
+	struct AnimPhase anim;
+	uint16_t hue;             // 0 - 1,535, see HuetoRGB()
+};
+
+struct Pattern_Blink_State {
+	struct AnimPhase anim;
+	uint8_t  showing_second;
+};
+
+// Shared by every pattern that plays an animation from animations.c
+struct Pattern_Animation_State {
+	struct AnimStream stream;
+	uint32_t last;            // now at the last step
+	uint32_t remaining;       // Time left on the frame showing, in authored ms x 100
+	uint8_t  stopped;         // Set when the animation was rejected, the frame stays black
+};
+
+
+// Registry
+//                                                                           speed
+//   init / step                                 state size                  default  min   max    brightness
+const struct Pattern pattern_registry[] = {
+#if PATTERN_ENABLE_BLINK
+	{ Pattern_Blink_init,           Pattern_Blink_step,
+	  PATTERN_STATE(struct Pattern_Blink_State),                             500,     20,   2550,  255 },
+#endif
+#if PATTERN_ENABLE_RAINBOW
+	{ Pattern_RainbowGradient_init, Pattern_RainbowGradient_step,
+	  PATTERN_STATE(struct Pattern_RainbowGradient_State),                   2,       1,    20,    255 },
+#endif
+#if PATTERN_ENABLE_CYCLE_RGB
+	{ Pattern_cycle_RGB_init,       Pattern_cycle_RGB_step,
+	  PATTERN_STATE(struct Pattern_cycle_RGB_State),                         500,     50,   2000,  255 },
+#endif
+#if PATTERN_ENABLE_SPINNER
+	{ Pattern_Spinner_init,         Pattern_Animation_step,
+	  PATTERN_STATE(struct Pattern_Animation_State),                         100,     25,   400,   255 },
+#endif
+};
+
+const uint8_t NUM_PATTERNS = sizeof(pattern_registry) / sizeof(pattern_registry[0]);
+
+_Static_assert(sizeof(pattern_registry) > 0, "At least one pattern must be enabled");
+
+
+// Pattern Selection
+
+// The pot takes over from a pattern's default speed once it has moved this far (out of 255) since the pattern
+// was selected, so switching patterns doesn't snap every pattern to wherever the pot was left
+#define POT_PICKUP 8
+
+static uint32_t pattern_state[(PATTERN_STATE_SIZE + 3) / 4];   // uint32_t so any state struct is aligned
+static uint8_t  current = 0;
+static uint16_t speed;
+static uint8_t  pot_at_select;
+static uint8_t  pot_last;
+static uint8_t  pot_active = 0;
+static uint8_t  pot_known = 0;      // The first reading after boot only says where the pot is
+
+void pattern_select(uint8_t index, struct Colour *frame, uint32_t now) {
+	if (index >= NUM_PATTERNS) index = 0;
+
+	current = index;
+	speed = pattern_registry[current].default_speed;
+	pot_at_select = pot_last;
+	pot_active = 0;
+
+	set_brightness(pattern_registry[current].default_brightness);
+	memset(pattern_state, 0, pattern_registry[current].state_size);
+	pattern_registry[current].init(pattern_state, frame, now);
+}
+
+void pattern_next(struct Colour *frame, uint32_t now) {
+	pattern_select((current + 1) % NUM_PATTERNS, frame, now);
+}
+
+void pattern_previous(struct Colour *frame, uint32_t now) {
+	pattern_select((current + NUM_PATTERNS - 1) % NUM_PATTERNS, frame, now);
+}
+
+uint8_t pattern_step(struct Colour *frame, uint32_t now) {
+	return pattern_registry[current].step(pattern_state, frame, now, speed);
+}
+
+// Maps a control reading (0 - full_scale) onto the active pattern's speed range
+void pattern_set_control(uint32_t value, uint32_t full_scale) {
+	const struct Pattern *pattern = &pattern_registry[current];
+
+	pot_last = (value * 255) / full_scale;
+
+	if (!pot_known) {
+		pot_known = 1;
+		pot_at_select = pot_last;
+		return;
+	}
+
+	if (!pot_active) {
+		int16_t moved = (int16_t)pot_last - pot_at_select;
+		if (moved < POT_PICKUP && moved > -POT_PICKUP) return;
+		pot_active = 1;
+	}
+
+	// Full resolution of the reading, not pot_last, so a 12-bit pot gives 4096 speed steps rather than 256
+	speed = pattern->speed_min + (((uint32_t)(pattern->speed_max - pattern->speed_min) * value) / full_scale);
+}
+
+uint8_t pattern_current(void) {
+	return current;
+}
+
+uint16_t pattern_get_speed(void) {
+	return speed;
+}
+
+// Overrides the default speed, e.g. with a saved one. Held until the pot is picked up.
+void pattern_set_speed(uint16_t value) {
+	const struct Pattern *pattern = &pattern_registry[current];
+	uint16_t low  = (pattern->speed_min < pattern->speed_max) ? pattern->speed_min : pattern->speed_max;
+	uint16_t high = (pattern->speed_min < pattern->speed_max) ? pattern->speed_max : pattern->speed_min;
+
+	if (value < low) value = low;
+	if (value > high) value = high;
+	speed = value;
+}
+
+
+// Patterns
+
+// Red, green, blue, each held for speed ms
+void Pattern_cycle_RGB_init(void *state_ptr, struct Colour *frame, uint32_t now) {
+	struct Pattern_cycle_RGB_State *state = state_ptr;
+
+	anim_phase_start(&state->anim, now);
+	state->colour_index = 0;
+	set_colour_whole_frame(frame, Red);
+}
+
+uint8_t Pattern_cycle_RGB_step(void *state_ptr, struct Colour *frame, uint32_t now, uint16_t speed) {
+	static const struct Colour *const sequence[] = { &Red, &Green, &Blue };
+	struct Pattern_cycle_RGB_State *state = state_ptr;
+
+	uint32_t phase = anim_phase_advance(&state->anim, now, 3 * (uint32_t)speed);
+	uint8_t colour_index = anim_phase_step(phase, 3);
+
+	if (colour_index == state->colour_index) return 0;
+
+	state->colour_index = colour_index;
+	set_colour_whole_frame(frame, *sequence[colour_index]);
+	return 1;
+}
+
+
+// implements a rainbow gradient as per
+// https://en.wikipedia.org/wiki/HSL_and_HSV#/media/File:HSV-RGB-comparison.svg
+// Walks the whole hue range (see HuetoRGB) at one hue step every speed ms, starting from all red
+void Pattern_RainbowGradient_init(void *state_ptr, struct Colour *frame, uint32_t now) {
+	struct Pattern_RainbowGradient_State *state = state_ptr;
+
+	anim_phase_start(&state->anim, now);
+	state->hue = 0;
+	set_colour_whole_frame(frame, HuetoRGB(0));
+}
+
+uint8_t Pattern_RainbowGradient_step(void *state_ptr, struct Colour *frame, uint32_t now, uint16_t speed) {
+	struct Pattern_RainbowGradient_State *state = state_ptr;
+
+	uint32_t phase = anim_phase_advance(&state->anim, now, 1536 * (uint32_t)speed);
+	uint16_t hue = anim_phase_step(phase, 1536);
+
+	if (hue == state->hue) return 0;
+
+	state->hue = hue;
+	set_colour_whole_frame(frame, HuetoRGB(hue));
+	return 1;
+}
+
+
+// Alternates between cyan and blue, each held for speed ms
+void Pattern_Blink_init(void *state_ptr, struct Colour *frame, uint32_t now) {
+	struct Pattern_Blink_State *state = state_ptr;
+
+	anim_phase_start(&state->anim, now);
+	state->showing_second = 0;
+	set_colour_whole_frame(frame, Cyan);
+}
+
+uint8_t Pattern_Blink_step(void *state_ptr, struct Colour *frame, uint32_t now, uint16_t speed) {
+	struct Pattern_Blink_State *state = state_ptr;
+
+	uint32_t phase = anim_phase_advance(&state->anim, now, 2 * (uint32_t)speed);
+	uint8_t showing_second = phase >> 31;   // Second half of the cycle
+
+	if (showing_second == state->showing_second) return 0;
+
+	state->showing_second = showing_second;
+	set_colour_whole_frame(frame, showing_second ? Blue : Cyan);
+	return 1;
+}
+
+
+// Plays a compressed animation (see anim_stream.c), speed is the playback rate in % of the authored timing
+// Frames fallen behind by more than this (e.g. after a long render) are skipped rather than all decoded at once
+#define ANIMATION_MAX_CATCH_UP 8
+
+static void animation_start(struct Pattern_Animation_State *state, struct Colour *frame, uint32_t now, const uint8_t *data) {
+	state->last = now;
+	state->stopped = !anim_stream_start(&state->stream, data);
+	if (state->stopped) {
+		clear_frame(frame);                  // Made for a different display
+		return;
+	}
+	state->remaining = anim_stream_next(&state->stream, frame) * 100;
+}
+
+uint8_t Pattern_Animation_step(void *state_ptr, struct Colour *frame, uint32_t now, uint16_t speed) {
+	struct Pattern_Animation_State *state = state_ptr;
+	if (state->stopped) return 0;
+
+	uint32_t elapsed = now - state->last;
+	uint8_t changed = 0;
+
+	state->last = now;
+	if (elapsed > 1000) elapsed = 1000;      // Keeps elapsed * speed well inside 32 bits
+	uint32_t progress = elapsed * speed;
+
+	for (uint8_t i = 0; progress >= state->remaining; i++) {
+		if (i == ANIMATION_MAX_CATCH_UP) {
+			progress = 0;
+			break;
+		}
+		progress -= state->remaining;
+		state->remaining = anim_stream_next(&state->stream, frame) * 100;
+		changed = 1;
+	}
+	state->remaining -= progress;
+	return changed;
+}
+
+// A comet chasing round the outside of the 3x3, once each in red, green and blue
+void Pattern_Spinner_init(void *state_ptr, struct Colour *frame, uint32_t now) {
+	animation_start(state_ptr, frame, now, anim_spinner);
+}
+
+/*
+// !TODO Rewrite with new functions
+void Pattern_RainbowGradientDiag(void) {
+	while (1) {
+		for (uint16_t i = 0; i < 1536; i++) {
+			HuetoRGB(2, i + 160);
+
+			HuetoRGB(1, i + 120);
+			HuetoRGB(5, i + 120);
+
+			HuetoRGB(0, i + 80);
+			HuetoRGB(4, i + 80);
+			HuetoRGB(8, i + 80);
+
+			HuetoRGB(3, i + 40);
+			HuetoRGB(7, i + 40);
+
+			HuetoRGB(6, i);
+
+			WS2812C_Send();
+			HAL_Delay(20);
+
+		}
+	}
+}
+*/
@@ -0,0 +1,287 @@
+/*
+ * power.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Every wait in the firmware sleeps the core instead of spinning.
+ *
+ * Sleep mode (__WFI) is the default: peripherals and DMA keep running, and any interrupt wakes the core
+ * again, so waits end just as quickly as before.
+ *
+ * When idle, sleep is tickless. SysTick would otherwise wake the core every ms just to count, even when
+ * nothing is due for hundreds of ms. If the next periodic task is at least POWER_TICKLESS_MIN_MS away:
+ *   - SysTick's interrupt is switched off and a TIM14 compare alarm is set for the task's deadline
+ *   - the core sleeps until that alarm, or until anything else (vsync, DMA, button) interrupts first
+ *   - on wake, still masked, the time slept is added to uwTick before any ISR can read HAL_GetTick()
+ * The part of a ms SysTick had already counted when it was switched off is carried across, so
+ * HAL_GetTick() keeps in step with real time however many times this happens.
+ *
+ * Sleeping safely means checking the wake condition and executing WFI with interrupts masked. Otherwise the
+ * interrupt that sets the condition could arrive between the check and the WFI, and the core would sleep
+ * through it until some unrelated interrupt came along. With PRIMASK set a pending interrupt still ends WFI;
+ * it's then taken as soon as interrupts are unmasked again.
+ *
+ * Stop mode is used instead when the scene is static (power_allow_stop(), from render) and nothing needs a
+ * clock: no frame being transmitted or waiting, no button gesture being sampled, and the ADC handed over to
+ * its watchdog. Stop halts the HSI and with it every timer, so:
+ *   - the RTC (on the LSI) sets an alarm for just before the next vsync or periodic task, whichever is first
+ *   - PB7 (EXTI) also wakes it, so a press is never missed
+ *   - the ADC isn't clocked in Stop and so can't wake it, but the watchdog gets a look at the pot every wake,
+ *     i.e. every frame
+ *   - on wake, the time spent stopped (from the RTC subsecond counter) is added back onto HAL_GetTick(), the
+ *     us timebase and the frame scheduler, so nothing downstream sees the gap
+ * SYSCLK is HSISYS, which is what the C0 wakes up on, so there is no clock tree to rebuild: the core runs at
+ * 48 MHz within a few us of the alarm.
+ *
+ * power_get_stats() gives the time spent in each mode (the rest is Run), how often Stop was entered and the
+ * worst wake latency, so the average current can be worked out from the datasheet figures for each mode.
+ *
+ * Bench measurements, not taken yet. Measure the supply current into VDD with the LEDs on their own supply,
+ * so only the MCU is counted, and note telemetry.cpu_load alongside each figure:
+ *  [ ] Run current with every wait spinning (firmware from before power.c) vs sleeping, same pattern and speed
+ *  [ ] Sleep and Stop current, on a static scene with the core held in one mode (e.g. a breakpoint on the wake)
+ *  [ ] Wake latency from Stop: RTC alarm, and a PB7 press to the first frame out. Toggle a spare pin on wake
+ *      and at start_frame_transfer() and scope it against the LED data line; wake_latency_us is only the
+ *      software's own estimate, at the RTC's 62.5 us resolution
+ */
+
+#include "power.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "frame_scheduler.h"
+#include "lib_WS2812C.h"
+#include "button.h"
+#include "adc_input.h"
+#include "clock_governor.h"
+#include "main.h"
+
+#define RTC_SUBSECONDS   (POWER_RTC_PREDIV_S + 1)
+
+static struct PowerStats stats;
+static uint8_t stop_allowed = 0;
+static uint32_t tick_carry_us = 0;    // Time counted towards the next ms by tickless sleeps, not yet in uwTick
+
+// Sleeps with interrupts already masked, and counts how long for
+static void sleep_masked(void) {
+	uint32_t start = timebase_now_us();
+	__WFI();
+	stats.sleep_us += timebase_now_us() - start;
+}
+
+// As sleep_masked(), but with SysTick off, for up to ms (less if anything else interrupts first)
+static void sleep_tickless_masked(uint32_t ms) {
+	uint32_t load = SysTick->LOAD;
+	uint32_t into_tick_us = ((load - SysTick->VAL) * 1000) / (load + 1);   // Since the last SysTick
+
+	HAL_SuspendTick();
+	timebase_set_alarm_us(ms * 1000 - into_tick_us);
+
+	uint32_t start = timebase_now_us();
+	__WFI();
+	uint32_t slept_us = timebase_now_us() - start;
+
+	timebase_cancel_alarm();
+
+	// uwTick catches up with the time since the last tick it counted, and SysTick restarts a full ms from now.
+	// The part ms left over is carried to the next time.
+	tick_carry_us += into_tick_us + slept_us;
+	uwTick += (tick_carry_us / 1000) * uwTickFreq;
+	tick_carry_us %= 1000;
+	SysTick->VAL = 0;
+	HAL_ResumeTick();
+
+	stats.sleep_us += slept_us;
+	stats.ticks_skipped += slept_us / 1000;
+}
+
+static void rtc_unlock(void) {
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+}
+
+static void rtc_lock(void) {
+	RTC->WPR = 0xFF;
+}
+
+// The subsecond counter counts down at POWER_RTC_TICK_HZ. Read until stable, as it's asynchronous to the bus.
+static uint32_t rtc_subseconds(void) {
+	uint32_t ss;
+	do {
+		ss = RTC->SSR;
+	} while (ss != RTC->SSR);
+	return ss;
+}
+
+static void rtc_init(void) {
+	__HAL_RCC_RTCAPB_CLK_ENABLE();
+
+	RCC->CSR2 |= RCC_CSR2_LSION;
+	while (!(RCC->CSR2 & RCC_CSR2_LSIRDY)) {}
+
+	MODIFY_REG(RCC->CSR1, RCC_CSR1_RTCSEL, RCC_CSR1_RTCSEL_1);   // LSI
+	RCC->CSR1 |= RCC_CSR1_RTCEN;
+
+	rtc_unlock();
+	RTC->ICSR |= RTC_ICSR_INIT;
+	while (!(RTC->ICSR & RTC_ICSR_INITF)) {}
+	RTC->PRER = POWER_RTC_PREDIV_S << RTC_PRER_PREDIV_S_Pos;     // Two writes, as the reference manual asks
+	RTC->PRER |= POWER_RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos;
+	RTC->CR |= RTC_CR_BYPSHAD;            // Read SSR directly, not through the shadow registers
+	RTC->ICSR &= ~RTC_ICSR_INIT;
+	rtc_lock();
+
+	EXTI->IMR1 |= EXTI_IMR1_IM19;         // RTC alarm can wake from Stop
+	HAL_NVIC_SetPriority(RTC_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_IRQn);
+}
+
+// Alarm A when the subsecond counter reaches ss, ignoring the time and date
+static void rtc_set_alarm(uint32_t ss) {
+	rtc_unlock();
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	while (!(RTC->ICSR & RTC_ICSR_ALRAWF)) {}
+	RTC->ALRMAR = RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 | RTC_ALRMAR_MSK1;
+	RTC->ALRMASSR = (15UL << RTC_ALRMASSR_MASKSS_Pos) | ss;
+	RTC->SCR = RTC_SCR_CALRAF;
+	RTC->CR |= RTC_CR_ALRAE | RTC_CR_ALRAIE;
+	rtc_lock();
+}
+
+static void rtc_cancel_alarm(void) {
+	rtc_unlock();
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	RTC->SCR = RTC_SCR_CALRAF;
+	rtc_lock();
+}
+
+// Puts back time that passed while SysTick, TIM14 and TIM16 were stopped
+static void skip_time(uint32_t us) {
+	static uint32_t remainder_us = 0;
+
+	remainder_us += us;
+	uwTick += remainder_us / 1000;
+	remainder_us %= 1000;
+
+	timebase_skip_us(us);
+	frame_scheduler_skip_us(us);
+}
+
+// Stops for about us (less if something else wakes it), with interrupts already masked
+static void stop_masked(uint32_t us) {
+	uint32_t ticks = (us * (POWER_RTC_TICK_HZ / 1000)) / 1000;
+	if (ticks >= RTC_SUBSECONDS) ticks = RTC_SUBSECONDS - 1;
+
+	uint32_t start = rtc_subseconds();
+	rtc_set_alarm((start + RTC_SUBSECONDS - ticks) % RTC_SUBSECONDS);
+
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	__WFI();
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	uint32_t elapsed = (start + RTC_SUBSECONDS - rtc_subseconds()) % RTC_SUBSECONDS;
+	rtc_cancel_alarm();
+
+	uint32_t stopped_us = (elapsed * 1000000) / POWER_RTC_TICK_HZ;
+	skip_time(stopped_us);
+
+	stats.stops++;
+	stats.stop_us += stopped_us;
+	if (elapsed < ticks) {
+		stats.early_wakes++;
+	} else {
+		uint32_t latency_us = ((elapsed - ticks) * 1000000) / POWER_RTC_TICK_HZ;
+		if (latency_us > stats.wake_latency_us) stats.wake_latency_us = latency_us;
+	}
+}
+
+// How long Stop mode can be used for right now, 0 if it can't
+static uint32_t stop_budget_us(uint32_t ms_until_task) {
+	if (!stop_allowed) return 0;
+	if (frame_transfer_busy() || frame_scheduler_frame_waiting() || !button_idle() || !adc_input_idle()) return 0;
+
+	uint32_t budget = frame_scheduler_us_until_vsync();
+	if (ms_until_task < budget / 1000) budget = ms_until_task * 1000;
+
+	if (budget < POWER_STOP_MIN_US + POWER_WAKE_MARGIN_US) return 0;
+	return budget - POWER_WAKE_MARGIN_US;
+}
+
+void power_init(void) {
+	CLEAR_BIT(SCB->SCR, SCB_SCR_SLEEPDEEP_Msk);   // WFI means Sleep unless stop_masked() says otherwise
+	__HAL_RCC_FLASH_CLK_SLEEP_DISABLE();          // Nothing reads flash while the core sleeps; DMA works from RAM
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	MODIFY_REG(PWR->CR1, PWR_CR1_LPMS, 0);        // Deep sleep = Stop mode
+
+#ifdef DEBUG
+	__HAL_RCC_DBGMCU_CLK_ENABLE();
+	HAL_DBGMCU_EnableDBGStopMode();               // Keep the debugger connected through Stop
+#endif
+
+	rtc_init();
+}
+
+// Sleeps until an interrupt sets *flag
+void power_wait_for(volatile uint8_t *flag) {
+	__disable_irq();
+	while (!*flag) {
+		sleep_masked();
+		__enable_irq();     // Let the interrupt that woke us run
+		__disable_irq();
+	}
+	__enable_irq();
+}
+
+// Whether the scene is static enough for Stop mode between frames
+void power_allow_stop(uint8_t allow) {
+	stop_allowed = allow;
+}
+
+// Call when the scheduler has nothing to run. Sleeps until the next interrupt, or stops until just before
+// the next vsync/task, unless a task became ready. Drops the clock first if it can, see clock_governor.c.
+void power_idle(void) {
+	__disable_irq();
+	uint32_t ms_until_task = scheduler_ms_until_next(HAL_GetTick());
+	if (ms_until_task != 0) {
+		if (!frame_transfer_busy() && !frame_scheduler_clock_due()) clock_governor_idle();
+
+		uint32_t stop_us = stop_budget_us(ms_until_task);
+		if (stop_us) {
+			stop_masked(stop_us);
+		} else if (ms_until_task >= POWER_TICKLESS_MIN_MS) {
+			sleep_tickless_masked(ms_until_task > POWER_TICKLESS_MAX_MS ? POWER_TICKLESS_MAX_MS : ms_until_task);
+		} else {
+			sleep_masked();
+		}
+	}
+	__enable_irq();
+}
+
+void power_get_stats(struct PowerStats *out) {
+	__disable_irq();
+	*out = stats;
+	__enable_irq();
+}
+
+// Called from RTC_IRQHandler. The alarm has already done its job by waking the core.
+void power_rtc_IRQHandler(void) {
+	RTC->SCR = RTC_SCR_CALRAF;
+}
+
+// Replaces the HAL's busy-waiting version. Same timing, as SysTick wakes the core every tick.
+void HAL_Delay(uint32_t Delay) {
+	uint32_t tickstart = HAL_GetTick();
+	uint32_t wait = Delay;
+
+	// Add a freq to guarantee minimum wait
+	if (wait < HAL_MAX_DELAY) {
+		wait += (uint32_t)(uwTickFreq);
+	}
+
+	while ((HAL_GetTick() - tickstart) < wait) {
+		__WFI();
+	}
+}
@@ -0,0 +1,106 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * A tiny run-to-completion scheduler for everything the main loop does.
+ *
+ * A task is just a function. It can be:
+ *   - periodic: runs every period_ms
+ *   - event-triggered: runs when something (usually an ISR) calls scheduler_signal() on it
+ *   - or both
+ * Each call to scheduler_run() runs the single highest priority task that's ready, then returns, so a
+ * high priority task (render) never waits behind more than one lower priority task.
+ *
+ * Tasks never preempt each other, so they can share data without locking. Only scheduler_signal() is
+ * called from ISRs; it writes a single byte, which the main loop clears before running the task, so a
+ * signal that arrives while the task is already running makes it run again rather than being lost.
+ */
+
+#include "scheduler.h"
+#include "main.h"
+
+struct Task {
+	TaskFunction run;
+	uint32_t period_ms;              // 0 for event-only tasks
+	uint32_t next_run;
+	uint8_t priority;
+	volatile uint8_t signalled;
+};
+
+static struct Task tasks[SCHEDULER_MAX_TASKS];
+static uint8_t num_tasks = 0;
+static uint8_t order[SCHEDULER_MAX_TASKS];   // Task ids sorted by priority
+
+// Returns the task id to pass to scheduler_signal()
+uint8_t scheduler_add_task(TaskFunction run, uint32_t period_ms, uint8_t priority) {
+	if (num_tasks >= SCHEDULER_MAX_TASKS) Error_Handler();
+
+	uint8_t id = num_tasks++;
+	tasks[id].run = run;
+	tasks[id].period_ms = period_ms;
+	tasks[id].next_run = HAL_GetTick() + period_ms;
+	tasks[id].priority = priority;
+	tasks[id].signalled = 0;
+
+	// Insert into the priority order, after any existing tasks of the same priority
+	uint8_t i = id;
+	while (i > 0 && tasks[order[i - 1]].priority > priority) {
+		order[i] = order[i - 1];
+		i--;
+	}
+	order[i] = id;
+
+	return id;
+}
+
+// Marks an event-triggered task ready. Safe to call from ISRs.
+void scheduler_signal(uint8_t task_id) {
+	tasks[task_id].signalled = 1;
+}
+
+// Runs the highest priority ready task, if any. Returns 1 if a task was run.
+uint8_t scheduler_run(void) {
+	uint32_t now = HAL_GetTick();
+
+	for (uint8_t i = 0; i < num_tasks; i++) {
+		struct Task *task = &tasks[order[i]];
+
+		if (task->signalled) {
+			task->signalled = 0;
+			task->run(now);
+			return 1;
+		}
+
+		if (task->period_ms && (int32_t)(now - task->next_run) >= 0) {
+			task->next_run += task->period_ms;
+			if ((int32_t)(now - task->next_run) >= 0) {
+				task->next_run = now + task->period_ms;   // Fell more than a period behind, don't try to catch up
+			}
+			task->run(now);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// How long until the next periodic task is due (0 if one is due now)
+// Event-triggered tasks aren't included; they're woken by their interrupt.
+uint32_t scheduler_ms_until_next(uint32_t now) {
+	uint32_t soonest = UINT32_MAX;
+
+	for (uint8_t i = 0; i < num_tasks; i++) {
+		if (tasks[i].signalled) return 0;
+		if (!tasks[i].period_ms) continue;
+
+		int32_t until = (int32_t)(tasks[i].next_run - now);
+		if (until <= 0) return 0;
+		if ((uint32_t)until < soonest) soonest = until;
+	}
+
+	return soonest;
+}
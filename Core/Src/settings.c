@@ -0,0 +1,195 @@
+/*
+ * settings.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * Keeps a handful of 32-bit settings (enum SettingKey) across power cycles, in the last flash page
+ * (the SETTINGS region in STM32C011J4MX_FLASH.ld, taken off the end of FLASH).
+ *
+ * Flash can only be erased a page at a time and a page survives ~10k erases, so nothing is rewritten in place.
+ * The page starts with a header (magic) and is followed by 8 byte records, one flash double word each: key,
+ * check, value. A change appends a record; at startup the page is read front to back, so the last record of
+ * each key wins. When the page is full it's erased, the current value of every key is written back, and the
+ * header goes on last. With 3 keys that's one erase per ~250 saves.
+ *
+ * Only one page is used because code space is short (16 KB in all). The price is that a reset in the ~25 ms
+ * between that erase and the header going back on loses the saved settings, and the next boot starts from
+ * the defaults. A reset at any other time loses nothing but the change being saved.
+ *
+ * The CPU stalls while flash is being programmed or erased (it runs from flash), so writes are kept out of
+ * the way of the animation:
+ *   - settings_set() only updates RAM. The settings task writes a key once it has sat unchanged for
+ *     SETTINGS_HOLD_MS, so turning the pot or stepping through patterns ends up as one record, not dozens.
+ *   - Records (~85 us each) are only programmed while the next vsync is more than SETTINGS_WRITE_GUARD_US away.
+ *   - A page erase (~22 ms, longer than a frame) only happens while main says the scene is static, see
+ *     settings_allow_erase(). Missing a vsync then changes nothing on the LEDs. A page that is still blank
+ *     (every page on a new device) is written without one, so the first save doesn't wait for a static scene.
+ */
+
+#include "settings.h"
+#include "frame_scheduler.h"
+#include "main.h"
+
+#define RECORD_SIZE     8             // One flash double word, the smallest thing that can be programmed
+#define HEADER_MAGIC    0x31544553    // "SET1"
+#define ERASED          0xFFFFFFFFU
+
+extern uint32_t _settings_start[];    // From STM32C011J4MX_FLASH.ld
+
+static uint32_t values[SETTING_KEYS];
+static uint32_t stored = 0;           // Keys with a value, bit per key
+static uint32_t dirty = 0;            // Keys changed since they were last written
+static uint32_t changed_at;           // HAL_GetTick() of the last change
+static uint8_t  page_valid = 0;       // The page has a header, so records can be appended
+static uint32_t next_free;            // Address of the first unwritten record
+static uint8_t erase_allowed = 0;
+static struct SettingsStats stats;
+
+#define PAGE  ((uint32_t)_settings_start)
+
+static uint16_t record_check(uint16_t key, uint32_t value) {
+	return ~(key ^ value ^ (value >> 16));
+}
+
+static uint8_t program(uint32_t address, uint32_t low, uint32_t high) {
+	if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address, ((uint64_t)high << 32) | low) != HAL_OK) {
+		stats.errors++;
+		return 0;
+	}
+	return 1;
+}
+
+static uint8_t program_record(uint32_t address, uint8_t key) {
+	return program(address, key | ((uint32_t)record_check(key, values[key]) << 16), values[key]);
+}
+
+// Loads the saved records. Call once, before any settings_get().
+void settings_init(void) {
+	if (*(const volatile uint32_t *)PAGE != HEADER_MAGIC) return;     // Never written, or torn by a reset
+	page_valid = 1;
+
+	uint32_t address;
+	for (address = PAGE + RECORD_SIZE; address < PAGE + FLASH_PAGE_SIZE; address += RECORD_SIZE) {
+		const volatile uint32_t *record = (const volatile uint32_t *)address;
+		if (record[0] == ERASED && record[1] == ERASED) break;
+
+		uint16_t key = record[0] & 0xFFFF;
+		if (key < SETTING_KEYS && (record[0] >> 16) == record_check(key, record[1])) {
+			values[key] = record[1];
+			stored |= 1UL << key;
+		}
+		// Anything else was torn by a reset while it was being programmed, and is skipped
+	}
+	next_free = address;
+}
+
+// Returns 1 and fills value if key has ever been saved
+uint8_t settings_get(uint8_t key, uint32_t *value) {
+	if (key >= SETTING_KEYS || !(stored & (1UL << key))) return 0;
+	*value = values[key];
+	return 1;
+}
+
+// Changes a setting in RAM. The settings task saves it later, see the top of this file.
+void settings_set(uint8_t key, uint32_t value) {
+	if (key >= SETTING_KEYS) return;
+	if ((stored & (1UL << key)) && values[key] == value) return;
+
+	values[key] = value;
+	stored |= 1UL << key;
+	dirty |= 1UL << key;
+	changed_at = HAL_GetTick();
+}
+
+// Lets the settings task erase the page (stalling the CPU for a frame or two). main allows it while the scene is static.
+void settings_allow_erase(uint8_t allow) {
+	erase_allowed = allow;
+}
+
+// Returns 1 if every word of the page is still erased
+static uint8_t page_blank(void) {
+	const volatile uint32_t *word = (const volatile uint32_t *)PAGE;
+	for (uint32_t i = 0; i < FLASH_PAGE_SIZE / 4; i++) {
+		if (word[i] != ERASED) return 0;
+	}
+	return 1;
+}
+
+static void write_dirty(void) {
+	HAL_FLASH_Unlock();
+	for (uint8_t key = 0; key < SETTING_KEYS; key++) {
+		if (!(dirty & (1UL << key))) continue;
+		if (program_record(next_free, key)) {
+			dirty &= ~(1UL << key);
+			stats.records++;
+		}
+		next_free += RECORD_SIZE;    // A failed record is skipped over either way
+	}
+	HAL_FLASH_Lock();
+}
+
+// Writes every setting into the page afresh, erasing it first unless it's already blank
+static void rewrite(uint8_t erase_first) {
+	FLASH_EraseInitTypeDef erase = {
+		.TypeErase = FLASH_TYPEERASE_PAGES,
+		.Page      = (PAGE - FLASH_BASE) / FLASH_PAGE_SIZE,
+		.NbPages   = 1,
+	};
+	uint32_t page_error;
+	uint8_t ok = 1;
+
+	HAL_FLASH_Unlock();
+	if (erase_first) {
+		if (HAL_FLASHEx_Erase(&erase, &page_error) != HAL_OK) {
+			stats.errors++;
+			HAL_FLASH_Lock();
+			return;
+		}
+		stats.erases++;
+		page_valid = 0;
+	}
+
+	uint32_t address = PAGE + RECORD_SIZE;
+	for (uint8_t key = 0; key < SETTING_KEYS; key++) {
+		if (!(stored & (1UL << key))) continue;
+		ok &= program_record(address, key);
+		address += RECORD_SIZE;
+	}
+
+	// Header last, so the page is only read back once it holds everything
+	if (ok && program(PAGE, HEADER_MAGIC, 0)) {
+		page_valid = 1;
+		next_free = address;
+		stats.records += (address - (PAGE + RECORD_SIZE)) / RECORD_SIZE;
+		dirty = 0;
+	}
+	HAL_FLASH_Lock();
+}
+
+void settings_task(uint32_t now) {
+	if (!dirty || (now - changed_at) < SETTINGS_HOLD_MS) return;
+	if (frame_scheduler_us_until_vsync() < SETTINGS_WRITE_GUARD_US) return;   // Try again next period
+
+	uint32_t needed = 0;
+	for (uint8_t key = 0; key < SETTING_KEYS; key++) {
+		if (dirty & (1UL << key)) needed += RECORD_SIZE;
+	}
+
+	if (page_valid && next_free + needed <= PAGE + FLASH_PAGE_SIZE) {
+		write_dirty();
+	} else if (page_blank()) {
+		rewrite(0);      // The first save: no erase, so no need to wait
+	} else if (erase_allowed) {
+		rewrite(1);
+	} else {
+		stats.deferred++;
+	}
+}
+
+// Only changed by the settings task, so no need to mask interrupts
+void settings_get_stats(struct SettingsStats *out) {
+	*out = stats;
+}
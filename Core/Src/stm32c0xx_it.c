@@ -22,6 +22,12 @@
 #include "stm32c0xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "timebase.h"
+#include "frame_scheduler.h"
+#include "button.h"
+#include "power.h"
+#include "lib_WS2812C.h"
+#include "adc_input.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,7 +61,6 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
-extern DMA_HandleTypeDef hdma_tim1_ch1;
 /* USER CODE BEGIN EV */
 
 /* USER CODE END EV */
@@ -154,20 +159,64 @@ void EXTI4_15_IRQHandler(void)
   /* USER CODE END EXTI4_15_IRQn 1 */
 }
 
+/* USER CODE BEGIN 1 */
+
 /**
-  * @brief This function handles DMA1 channel 1 interrupt.
+  * @brief This function handles DMA1 channel 1 interrupt (WS2812 transmit complete).
+  * Not generated by CubeMX, as the transmit path is register level rather than HAL_DMA.
   */
-void DMA1_Channel1_IRQHandler(void)
+RAMFUNC void DMA1_Channel1_IRQHandler(void)
 {
-  /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
+  frame_transfer_IRQHandler();
+}
 
-  /* USER CODE END DMA1_Channel1_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_tim1_ch1);
-  /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
+/**
+  * @brief This function handles DMA1 channel 2 and channel 3 interrupts (ADC1 half buffers).
+  * Not generated by CubeMX, as the ADC is run at register level rather than through HAL_ADC.
+  */
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  adc_input_dma_IRQHandler();
+}
 
-  /* USER CODE END DMA1_Channel1_IRQn 1 */
+/**
+  * @brief This function handles ADC1 interrupt (analog watchdog 1).
+  */
+void ADC1_IRQHandler(void)
+{
+  adc_input_IRQHandler();
 }
 
-/* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles TIM14 global interrupt (microsecond timebase).
+  */
+void TIM14_IRQHandler(void)
+{
+  timebase_IRQHandler();
+}
+
+/**
+  * @brief This function handles TIM16 global interrupt (frame scheduler vsync).
+  */
+void TIM16_IRQHandler(void)
+{
+  frame_scheduler_IRQHandler();
+}
+
+/**
+  * @brief This function handles TIM17 global interrupt (button sampling).
+  */
+void TIM17_IRQHandler(void)
+{
+  button_IRQHandler();
+}
+
+/**
+  * @brief This function handles RTC interrupt through EXTI line 19 (Stop mode wakeup).
+  */
+void RTC_IRQHandler(void)
+{
+  power_rtc_IRQHandler();
+}
 
 /* USER CODE END 1 */
@@ -0,0 +1,153 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+
+/*
+ * HAL_GetTick() only counts milliseconds, which is too coarse to time a frame (~300 us to encode
+ * for 9 LEDs) or to schedule anything finer. This is a microsecond clock built on TIM14:
+ *   - TIM14 is prescaled to count at 1 MHz and free-runs through its 16-bit range
+ *   - its update interrupt adds 0x10000 to the upper half every time it wraps (every 65.5 ms)
+ *   - timebase_now_us() combines the two
+ *
+ * timebase_now_us() is safe to call from any ISR and with interrupts disabled: if the counter has wrapped
+ * but the update interrupt hasn't been serviced yet (because it can't preempt the caller), the pending
+ * update flag is accounted for directly.
+ *
+ * Registers are written directly rather than through the HAL TIM driver so the read path is a handful
+ * of instructions and never depends on HAL handle state.
+ *
+ * TIM14 stops along with everything else in Stop mode, so power.c adds the time spent stopped back on
+ * with timebase_skip_us().
+ *
+ * Compare channel 1 doubles as a one-shot wakeup alarm (timebase_set_alarm_us()), which is what lets
+ * power.c switch SysTick off while the core sleeps.
+ */
+
+#include "timebase.h"
+#include "main.h"
+
+static volatile uint32_t upper = 0;   // Counter wraps so far shifted into the upper 16 bits, plus skipped time
+
+void timebase_init(void) {
+	__HAL_RCC_TIM14_CLK_ENABLE();
+
+	TIM14->CR1 = 0;
+	TIM14->PSC = (SystemCoreClock / TIMEBASE_HZ) - 1;   // 1 us per count
+	TIM14->ARR = 0xFFFF;
+	TIM14->EGR = TIM_EGR_UG;                            // Load the prescaler now instead of at the first wrap
+	TIM14->SR = 0;                                      // UG sets the update flag, clear it so it isn't counted
+	TIM14->DIER = TIM_DIER_UIE;
+	upper = 0;
+
+	HAL_NVIC_SetPriority(TIM14_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(TIM14_IRQn);
+
+	TIM14->CR1 = TIM_CR1_CEN;
+}
+
+// SysTick cycles from one reading of VAL to a later one. It counts down, reloading from LOAD.
+static uint32_t systick_cycles(uint32_t from, uint32_t to) {
+	return (from >= to) ? from - to : from + SysTick->LOAD + 1 - to;
+}
+
+// Moves timers counting at TIMEBASE_HZ (TIM14 first) onto a new clock without them losing time. switch_clock,
+// if given, makes the change; without one the clock has already changed. Call with interrupts disabled.
+//   - UG loads the new prescaler but restarts the prescaler's own counter, throwing away the part of a tick
+//     it had counted. So the switch is made straight after a TIM14 tick, when there's next to nothing to lose.
+//     The timers are all reloaded together here, so their prescalers stay in step with TIM14's.
+//   - The time from that tick to the UG is measured on SysTick, which counts CPU cycles and so stays exact
+//     across the switch, and added back onto the counts. The part of a us left over carries to the next call.
+void timebase_retune_timers(TIM_TypeDef *const *timers, uint32_t num_timers, uint32_t new_hz, void (*switch_clock)(void)) {
+	static uint32_t carry_ns = 0;
+	uint32_t old_mhz = SystemCoreClock / 1000000;
+	uint32_t new_mhz = new_hz / 1000000;
+	uint32_t counts[TIMEBASE_MAX_TIMERS];
+
+	for (uint32_t i = 0; i < num_timers; i++) {
+		timers[i]->PSC = (new_hz / TIMEBASE_HZ) - 1;   // Preloaded, not used until the UG below
+		timers[i]->CR1 |= TIM_CR1_URS;                 // ...which mustn't set the update flag
+	}
+
+	uint32_t tick = TIM14->CNT;
+	while (TIM14->CNT == tick) {}
+	uint32_t start = SysTick->VAL;
+	for (uint32_t i = 0; i < num_timers; i++) {
+		counts[i] = timers[i]->CNT;
+	}
+
+	uint32_t before = SysTick->VAL;
+	if (switch_clock) switch_clock();
+	uint32_t after = SysTick->VAL;
+	for (uint32_t i = 0; i < num_timers; i++) {
+		timers[i]->EGR = TIM_EGR_UG;
+	}
+	uint32_t loaded = SysTick->VAL;
+
+	uint32_t ns = carry_ns + (systick_cycles(start, before) * 1000) / old_mhz +
+	              (systick_cycles(after, loaded) * 1000) / new_mhz;
+	carry_ns = ns % 1000;
+
+	for (uint32_t i = 0; i < num_timers; i++) {
+		uint32_t count = counts[i];
+		if (timers[i]->CR1 & TIM_CR1_CEN) count += ns / 1000;   // A stopped timer hasn't missed anything
+		if (count > timers[i]->ARR) count = timers[i]->ARR;     // Update on the next tick rather than wrap past it
+		timers[i]->CNT = count;
+		timers[i]->CR1 &= ~TIM_CR1_URS;
+	}
+}
+
+RAMFUNC uint32_t timebase_now_us(void) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t high = upper;
+	uint32_t low = TIM14->CNT;
+
+	// Wrapped, but the update interrupt hasn't run yet
+	if (TIM14->SR & TIM_SR_UIF) {
+		low = TIM14->CNT;     // Re-read, as the first read may have been just before the wrap
+		high += 0x10000;
+	}
+
+	__set_PRIMASK(primask);
+	return high + low;
+}
+
+uint32_t timebase_elapsed_us(uint32_t start) {
+	return timebase_now_us() - start;
+}
+
+// Moves the clock on by time that passed while TIM14 was stopped
+void timebase_skip_us(uint32_t us) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	upper += us;
+	__set_PRIMASK(primask);
+}
+
+// Interrupts (and so wakes the core) in us, up to 65535 us. The interrupt does nothing else.
+void timebase_set_alarm_us(uint32_t us) {
+	if (us > 0xFFFF) us = 0xFFFF;
+	TIM14->CCR1 = (TIM14->CNT + us) & 0xFFFF;
+	TIM14->SR = ~TIM_SR_CC1IF;
+	TIM14->DIER |= TIM_DIER_CC1IE;
+}
+
+void timebase_cancel_alarm(void) {
+	TIM14->DIER &= ~TIM_DIER_CC1IE;
+	TIM14->SR = ~TIM_SR_CC1IF;
+}
+
+// Called from TIM14_IRQHandler
+void timebase_IRQHandler(void) {
+	if (TIM14->SR & TIM_SR_UIF) {
+		TIM14->SR = ~TIM_SR_UIF;
+		upper += 0x10000;
+	}
+	if ((TIM14->DIER & TIM_DIER_CC1IE) && (TIM14->SR & TIM_SR_CC1IF)) {
+		timebase_cancel_alarm();
+	}
+}
@@ -5,31 +5,73 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../Core/Src/adc_input.c \
+../Core/Src/anim_clock.c \
+../Core/Src/anim_stream.c \
+../Core/Src/animations.c \
+../Core/Src/button.c \
+../Core/Src/clock_governor.c \
+../Core/Src/derating.c \
+../Core/Src/event_queue.c \
+../Core/Src/frame_scheduler.c \
 ../Core/Src/lib_WS2812C.c \
 ../Core/Src/main.c \
+../Core/Src/patterns.c \
+../Core/Src/power.c \
+../Core/Src/scheduler.c \
+../Core/Src/settings.c \
 ../Core/Src/stm32c0xx_hal_msp.c \
 ../Core/Src/stm32c0xx_it.c \
 ../Core/Src/syscalls.c \
 ../Core/Src/sysmem.c \
-../Core/Src/system_stm32c0xx.c 
+../Core/Src/system_stm32c0xx.c \
+../Core/Src/timebase.c 
 
 C_DEPS += \
+./Core/Src/adc_input.d \
+./Core/Src/anim_clock.d \
+./Core/Src/anim_stream.d \
+./Core/Src/animations.d \
+./Core/Src/button.d \
+./Core/Src/clock_governor.d \
+./Core/Src/derating.d \
+./Core/Src/event_queue.d \
+./Core/Src/frame_scheduler.d \
 ./Core/Src/lib_WS2812C.d \
 ./Core/Src/main.d \
+./Core/Src/patterns.d \
+./Core/Src/power.d \
+./Core/Src/scheduler.d \
+./Core/Src/settings.d \
 ./Core/Src/stm32c0xx_hal_msp.d \
 ./Core/Src/stm32c0xx_it.d \
 ./Core/Src/syscalls.d \
 ./Core/Src/sysmem.d \
-./Core/Src/system_stm32c0xx.d 
+./Core/Src/system_stm32c0xx.d \
+./Core/Src/timebase.d 
 
 OBJS += \
+./Core/Src/adc_input.o \
+./Core/Src/anim_clock.o \
+./Core/Src/anim_stream.o \
+./Core/Src/animations.o \
+./Core/Src/button.o \
+./Core/Src/clock_governor.o \
+./Core/Src/derating.o \
+./Core/Src/event_queue.o \
+./Core/Src/frame_scheduler.o \
 ./Core/Src/lib_WS2812C.o \
 ./Core/Src/main.o \
+./Core/Src/patterns.o \
+./Core/Src/power.o \
+./Core/Src/scheduler.o \
+./Core/Src/settings.o \
 ./Core/Src/stm32c0xx_hal_msp.o \
 ./Core/Src/stm32c0xx_it.o \
 ./Core/Src/syscalls.o \
 ./Core/Src/sysmem.o \
-./Core/Src/system_stm32c0xx.o 
+./Core/Src/system_stm32c0xx.o \
+./Core/Src/timebase.o 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -39,7 +81,7 @@ Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/lib_WS2812C.cyclo ./Core/Src/lib_WS2812C.d ./Core/Src/lib_WS2812C.o ./Core/Src/lib_WS2812C.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/stm32c0xx_hal_msp.cyclo ./Core/Src/stm32c0xx_hal_msp.d ./Core/Src/stm32c0xx_hal_msp.o ./Core/Src/stm32c0xx_hal_msp.su ./Core/Src/stm32c0xx_it.cyclo ./Core/Src/stm32c0xx_it.d ./Core/Src/stm32c0xx_it.o ./Core/Src/stm32c0xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32c0xx.cyclo ./Core/Src/system_stm32c0xx.d ./Core/Src/system_stm32c0xx.o ./Core/Src/system_stm32c0xx.su
+	-$(RM) ./Core/Src/adc_input.cyclo ./Core/Src/adc_input.d ./Core/Src/adc_input.o ./Core/Src/adc_input.su ./Core/Src/anim_clock.cyclo ./Core/Src/anim_clock.d ./Core/Src/anim_clock.o ./Core/Src/anim_clock.su ./Core/Src/anim_stream.cyclo ./Core/Src/anim_stream.d ./Core/Src/anim_stream.o ./Core/Src/anim_stream.su ./Core/Src/animations.cyclo ./Core/Src/animations.d ./Core/Src/animations.o ./Core/Src/animations.su ./Core/Src/button.cyclo ./Core/Src/button.d ./Core/Src/button.o ./Core/Src/button.su ./Core/Src/clock_governor.cyclo ./Core/Src/clock_governor.d ./Core/Src/clock_governor.o ./Core/Src/clock_governor.su ./Core/Src/derating.cyclo ./Core/Src/derating.d ./Core/Src/derating.o ./Core/Src/derating.su ./Core/Src/event_queue.cyclo ./Core/Src/event_queue.d ./Core/Src/event_queue.o ./Core/Src/event_queue.su ./Core/Src/frame_scheduler.cyclo ./Core/Src/frame_scheduler.d ./Core/Src/frame_scheduler.o ./Core/Src/frame_scheduler.su ./Core/Src/lib_WS2812C.cyclo ./Core/Src/lib_WS2812C.d ./Core/Src/lib_WS2812C.o ./Core/Src/lib_WS2812C.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/patterns.cyclo ./Core/Src/patterns.d ./Core/Src/patterns.o ./Core/Src/patterns.su ./Core/Src/power.cyclo ./Core/Src/power.d ./Core/Src/power.o ./Core/Src/power.su ./Core/Src/scheduler.cyclo ./Core/Src/scheduler.d ./Core/Src/scheduler.o ./Core/Src/scheduler.su ./Core/Src/settings.cyclo ./Core/Src/settings.d ./Core/Src/settings.o ./Core/Src/settings.su ./Core/Src/stm32c0xx_hal_msp.cyclo ./Core/Src/stm32c0xx_hal_msp.d ./Core/Src/stm32c0xx_hal_msp.o ./Core/Src/stm32c0xx_hal_msp.su ./Core/Src/stm32c0xx_it.cyclo ./Core/Src/stm32c0xx_it.d ./Core/Src/stm32c0xx_it.o ./Core/Src/stm32c0xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32c0xx.cyclo ./Core/Src/system_stm32c0xx.d ./Core/Src/system_stm32c0xx.o ./Core/Src/system_stm32c0xx.su ./Core/Src/timebase.cyclo ./Core/Src/timebase.d ./Core/Src/timebase.o ./Core/Src/timebase.su
 
 .PHONY: clean-Core-2f-Src
 
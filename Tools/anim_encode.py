@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+#
+# anim_encode.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Adam Gulyas
+#
+# Compresses designer-authored animations into the format decoded by anim_stream.c, and writes them out
+# as Core/Src/animations.c and Core/Inc/animations.h.
+#
+# An animation is a JSON file:
+#   {
+#     "name": "spinner",                        C identifier, becomes anim_spinner[]
+#     "leds": 9,                                must match NUM_LEDS
+#     "frames": [
+#       { "ms": 100, "leds": ["#FF0000", "#000000", ...] },    one colour per LED, in LED order
+#       { "ms": 500, "same": true },                           hold the previous frame a while longer
+#       ...
+#     ]
+#   }
+# Durations are rounded to ANIM_TICK_MS (10 ms) and can be anything from 10 ms up; long ones are split
+# into holds. The animation loops.
+#
+# Colours go in a table in the header (at most 255 per animation) and frames refer to them by index. Each
+# frame is stored as whichever is smaller: a KEY frame (every LED, runs of one colour collapsed) or a
+# DELTA against the frame before (only the LEDs that changed, as runs). Identical frames merge into one
+# longer frame. --key-interval forces a KEY frame every so many frames, which costs space but bounds how
+# far an error in the data can carry.
+#
+# Usage: python3 Tools/anim_encode.py [--key-interval N] Tools/animations/*.json
+
+import argparse
+import json
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "Core", "Inc", "anim_stream.h")
+OUT_C = os.path.join(ROOT, "Core", "Src", "animations.c")
+OUT_H = os.path.join(ROOT, "Core", "Inc", "animations.h")
+
+BANNER = """/*
+ * {name}
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: Adam Gulyas
+ */
+"""
+
+
+def read_format():
+	# The format constants come from anim_stream.h, so the two can't drift apart
+	with open(HEADER) as f:
+		text = f.read()
+	names = ("ANIM_FORMAT_VERSION", "ANIM_TICK_MS", "ANIM_FRAME_KEY", "ANIM_FRAME_DELTA", "ANIM_MAX_RUNS")
+	return {n: int(re.search(r"#define\s+%s\s+(\d+)" % n, text).group(1)) for n in names}
+
+
+def parse_colour(text):
+	value = text.lstrip("#")
+	if len(value) != 6:
+		raise ValueError("colour %r isn't #RRGGBB" % text)
+	return tuple(int(value[i:i + 2], 16) for i in (0, 2, 4))
+
+
+def runs_of(colours, first=0):
+	# Splits colours into (first LED, length, colour) runs of one colour, at most 255 long
+	runs = []
+	for i, colour in enumerate(colours):
+		if runs and runs[-1][2] == colour and runs[-1][0] + runs[-1][1] == first + i and runs[-1][1] < 255:
+			runs[-1][1] += 1
+		else:
+			runs.append([first + i, 1, colour])
+	return runs
+
+
+def key_body(frame, table):
+	body = bytearray()
+	for _, length, colour in runs_of(frame):
+		body += bytes([length, table[colour]])
+	return body
+
+
+def delta_runs(previous, frame):
+	runs = []
+	for i, (old, new) in enumerate(zip(previous, frame)):
+		if old == new:
+			continue
+		if runs and runs[-1][2] == new and runs[-1][0] + runs[-1][1] == i and runs[-1][1] < 255:
+			runs[-1][1] += 1
+		else:
+			runs.append([i, 1, new])
+	return runs
+
+
+def encode(animation, fmt, key_interval):
+	leds = animation["leds"]
+	tick = fmt["ANIM_TICK_MS"]
+
+	# Expand to (colours, ticks) and merge identical neighbours
+	frames = []
+	for index, entry in enumerate(animation["frames"]):
+		ticks = max(1, round(entry["ms"] / tick))
+		if entry.get("same"):
+			if not frames:
+				raise ValueError("frame 0 can't be \"same\"")
+			colours = frames[-1][0]
+		else:
+			colours = [parse_colour(c) for c in entry["leds"]]
+			if len(colours) != leds:
+				raise ValueError("frame %d has %d LEDs, expected %d" % (index, len(colours), leds))
+		if frames and frames[-1][0] == colours:
+			frames[-1][1] += ticks
+		else:
+			frames.append([colours, ticks])
+
+	# Colour table, in order of first use
+	table = {}
+	for colours, _ in frames:
+		for colour in colours:
+			table.setdefault(colour, len(table))
+	if len(table) > 255:
+		raise ValueError("%d colours, at most 255" % len(table))
+
+	out = bytearray()
+	count = 0
+	previous = None
+	since_key = 0
+	for colours, ticks in frames:
+		first = True
+		while ticks > 0:
+			chunk = min(ticks, 255)
+			ticks -= chunk
+			if not first:
+				# Overflow of a long frame, a DELTA with no runs holds it
+				out += bytes([fmt["ANIM_FRAME_DELTA"] << 6, chunk])
+				count += 1
+				continue
+			first = False
+
+			key = key_body(colours, table)
+			delta = delta_runs(previous, colours) if previous is not None else None
+			delta_size = len(delta) * 3 if delta is not None else None
+			use_key = (delta is None or len(delta) > fmt["ANIM_MAX_RUNS"] or len(key) <= delta_size or
+					   (key_interval and since_key >= key_interval))
+			if use_key:
+				out += bytes([fmt["ANIM_FRAME_KEY"] << 6, chunk]) + key
+				since_key = 0
+			else:
+				out += bytes([(fmt["ANIM_FRAME_DELTA"] << 6) | len(delta), chunk])
+				for first_led, length, colour in delta:
+					out += bytes([first_led, length, table[colour]])
+			since_key += 1
+			count += 1
+			previous = colours
+
+	if count > 0xFFFF:
+		raise ValueError("too many frames")
+	header = bytes([fmt["ANIM_FORMAT_VERSION"], leds, count & 0xFF, count >> 8, len(table)])
+	for colour in table:
+		header += bytes(colour)
+	total_ms = sum(ticks for _, ticks in frames) * tick
+	return header + out, count, total_ms, len(frames) * leds * 3
+
+
+def c_array(name, data):
+	lines = []
+	for i in range(0, len(data), 16):
+		lines.append("\t" + " ".join("0x%02X," % b for b in data[i:i + 16]))
+	return "const uint8_t %s[%d] = {\n%s\n};\n" % (name, len(data), "\n".join(lines))
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Compress animations for anim_stream.c")
+	parser.add_argument("inputs", nargs="+", help="animation JSON files")
+	parser.add_argument("--key-interval", type=int, default=0, help="force a KEY frame every N frames, 0 for only the first")
+	args = parser.parse_args()
+
+	fmt = read_format()
+	encoded = []
+	for path in args.inputs:
+		with open(path) as f:
+			animation = json.load(f)
+		name = "anim_" + animation["name"]
+		if not re.match(r"^[A-Za-z_]\w*$", name):
+			sys.exit("%s: name must be a C identifier" % path)
+		data, count, total_ms, raw = encode(animation, fmt, args.key_interval)
+		encoded.append((name, os.path.relpath(path, ROOT).replace(os.sep, "/"), data))
+		print("%-20s %4d frames, %6.2f s, %5d bytes (raw %d, %.1fx)" %
+			  (name, count, total_ms / 1000, len(data), raw, raw / len(data)))
+
+	with open(OUT_H, "w") as f:
+		f.write(BANNER.format(name="animations.h"))
+		f.write("\n// Generated by Tools/anim_encode.py, edit the JSON sources and regenerate rather than this file\n\n")
+		f.write("#ifndef INC_ANIMATIONS_H_\n#define INC_ANIMATIONS_H_\n\n#include <stdint.h>\n\n")
+		for name, source, data in encoded:
+			f.write("extern const uint8_t %s[%d];    // %s\n" % (name, len(data), source))
+		f.write("\n\n#endif /* INC_ANIMATIONS_H_ */\n")
+
+	with open(OUT_C, "w") as f:
+		f.write(BANNER.format(name="animations.c"))
+		f.write("\n// Generated by Tools/anim_encode.py, edit the JSON sources and regenerate rather than this file\n")
+		f.write("// Format in anim_stream.h\n\n#include \"animations.h\"\n")
+		for name, source, data in encoded:
+			f.write("\n// %s\n" % source)
+			f.write(c_array(name, data))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+#
+# ram_report.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Adam Gulyas
+#
+# Reports how RAM and flash use scales with NUM_LEDS, so a deployment can be sized
+# before flashing.
+#
+# The LED buffers are computed from the same formulas as LED_RAM_BYTES in lib_WS2812C.h:
+#   pwmData        (24 * NUM_LEDS + 600) * 2 bytes
+#   Colour frame   3 bytes per LED (main.c)
+# Everything else (HAL handles, queues, .RamFunc code, stack and heap) is fixed, and is
+# taken from the map file of the last build when there is one.
+#
+# A map that doesn't match the sources would quote figures for some other firmware, so the
+# report refuses to use one that is missing any Core/Src object, or is older than any source,
+# header, the linker script or the .ioc. Rebuild first, or pass --stale to see its figures
+# anyway, marked as such.
+#
+# Usage: python3 Tools/ram_report.py [--map Debug/Light-Array-9.map] [--leds 9,16,25] [--stale]
+
+import argparse
+import glob
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "Core", "Inc", "lib_WS2812C.h")
+LINKER = os.path.join(ROOT, "STM32C011J4MX_FLASH.ld")
+IOC = os.path.join(ROOT, "Light-Array-9.ioc")
+MAP = os.path.join(ROOT, "Debug", "Light-Array-9.map")
+
+# Input sections that scale with NUM_LEDS, either in their own
+# sections or, for maps from before they had them, in .bss
+LED_SECTIONS = re.compile(r"^ (\.frame_buffers|\.encode_buffers|"
+                          r"\.bss\.(pwmData|frame)(\.\d+)?)\b")
+
+RAM_OUTPUTS = (".data", ".bss", ".frame_buffers", ".encode_buffers", "._user_heap_stack")
+FLASH_OUTPUTS = (".isr_vector", ".text", ".rodata", ".ARM.extab", ".ARM",
+                 ".preinit_array", ".init_array", ".fini_array", ".data")
+
+
+def read_define(text, name):
+	match = re.search(r"^#define\s+%s\s+(\S+)" % name, text, re.M)
+	return int(match.group(1), 0) if match else None
+
+
+def read_size(text, name):
+	# Linker script sizes are either "6K" or "0x400"
+	match = re.search(r"%s\s*=\s*([0-9A-Fa-fx]+)(K?)" % name, text)
+	if not match:
+		return None
+	value = int(match.group(1), 0)
+	return value * 1024 if match.group(2) else value
+
+
+def led_ram_bytes(leds):
+	return (24 * leds + 600) * 2 + leds * 3
+
+
+def parse_map(path):
+	# Returns (RAM used by output sections, flash used, RAM in LED buffers)
+	ram = flash = led = 0
+	with open(path, errors="replace") as f:
+		lines = f.read().splitlines()
+	for i, line in enumerate(lines):
+		fields = line.split()
+		if not fields:
+			continue
+		# Long section names push the address and size onto the next line
+		if len(fields) == 1 and i + 1 < len(lines):
+			fields = fields + lines[i + 1].split()
+		if len(fields) < 3 or not fields[1].startswith("0x") or not fields[2].startswith("0x"):
+			continue
+		size = int(fields[2], 16)
+		if not line.startswith(" "):
+			if fields[0] in RAM_OUTPUTS:
+				ram += size
+			if fields[0] in FLASH_OUTPUTS:
+				flash += size
+		elif LED_SECTIONS.match(line):
+			led += size
+	return ram, flash, led
+
+
+def map_problems(path):
+	# Reasons the map can't be trusted to describe the current sources, empty if there are none
+	with open(path, errors="replace") as f:
+		text = f.read()
+	sources = sorted(glob.glob(os.path.join(ROOT, "Core", "Src", "*.c")))
+	problems = ["%s was not linked" % os.path.relpath(c, ROOT) for c in sources
+				if not re.search(r"Core/Src/%s\.o\b" % re.escape(os.path.basename(c)[:-2]), text)]
+
+	inputs = sources + glob.glob(os.path.join(ROOT, "Core", "Inc", "*.h")) + [LINKER, IOC]
+	newest = max(inputs, key=os.path.getmtime)
+	if os.path.getmtime(newest) > os.path.getmtime(path):
+		problems.append("%s is newer than the map" % os.path.relpath(newest, ROOT))
+	return problems
+
+
+def max_leds(fits, limit=4096):
+	leds = 0
+	while leds < limit and fits(leds + 1):
+		leds += 1
+	return leds
+
+
+def main():
+	parser = argparse.ArgumentParser(description="RAM and flash use against NUM_LEDS")
+	parser.add_argument("--map", default=MAP, help="map file of the last build")
+	parser.add_argument("--leds", help="comma separated NUM_LEDS values to report")
+	parser.add_argument("--stale", action="store_true", help="use the map even if it doesn't match the sources")
+	args = parser.parse_args()
+
+	with open(HEADER) as f:
+		header = f.read()
+	with open(LINKER) as f:
+		linker = f.read()
+
+	num_leds = read_define(header, "NUM_LEDS")
+	budget = read_define(header, "LED_RAM_BUDGET")
+	ram_size = read_size(linker, r"RAM\s+\(xrw\)\s*:\s*ORIGIN\s*=\s*0x[0-9A-Fa-f]+,\s*LENGTH")
+	flash_size = read_size(linker, r"FLASH\s+\(rx\)\s*:\s*ORIGIN\s*=\s*0x[0-9A-Fa-f]+,\s*LENGTH")
+	stack = read_size(linker, "_Min_Stack_Size")
+	heap = read_size(linker, "_Min_Heap_Size")
+
+	# RAM that doesn't depend on the LED count, stack and heap included
+	flash = None
+	if os.path.exists(args.map):
+		problems = map_problems(args.map)
+		for problem in problems:
+			print("warning: %s" % problem, file=sys.stderr)
+		if problems and not args.stale:
+			print("error: %s is out of date, rebuild or pass --stale" % os.path.relpath(args.map, ROOT),
+				  file=sys.stderr)
+			return 1
+		ram, flash, led = parse_map(args.map)
+		fixed = ram - led
+		source = "%s (LED buffers %d of %d bytes excluded)%s" % (os.path.relpath(args.map, ROOT), led, ram,
+																 ", STALE" if problems else "")
+	else:
+		fixed = stack + heap
+		source = "no map file, stack and heap only"
+
+	if args.leds:
+		counts = sorted({int(n) for n in args.leds.split(",")})
+	else:
+		counts = sorted({num_leds, 16, 25, 36, 49, 64, 81, 100})
+
+	print("NUM_LEDS %d, LED_RAM_BUDGET %d" % (num_leds, budget))
+	print("RAM %d bytes (stack %d, heap %d), fixed use %d bytes from %s" %
+		  (ram_size, stack, heap, fixed, source))
+	if flash is not None:
+		# The LED count only changes loop bounds, so flash is the same for every row below
+		print("Flash %d of %d bytes (%d%%), independent of NUM_LEDS%s" %
+			  (flash, flash_size, 100 * flash // flash_size, ", STALE" if problems else ""))
+	print()
+
+	print("%8s %10s %10s %10s  %s" % ("NUM_LEDS", "LED bytes", "RAM total", "RAM free", "status"))
+	for leds in counts:
+		led = led_ram_bytes(leds)
+		total = fixed + led
+		if total > ram_size:
+			status = "does not link"
+		elif led > budget:
+			status = "over LED_RAM_BUDGET"
+		else:
+			status = "ok"
+		marker = " <" if leds == num_leds else ""
+		print("%8d %10d %10d %10d  %s%s" % (leds, led, total, ram_size - total, status, marker))
+	print()
+
+	by_budget = max_leds(lambda n: led_ram_bytes(n) <= budget)
+	by_ram = max_leds(lambda n: fixed + led_ram_bytes(n) <= ram_size)
+	print("Largest NUM_LEDS: %d within LED_RAM_BUDGET, %d before the linker fails" % (by_budget, by_ram))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,311 @@
+#!/usr/bin/env python3
+#
+# stack_report.py
+#
+#  Created on: Oct 19, 2026
+#      Author: Adam Gulyas
+#
+# Worst-case stack depth per entry point (main and every ISR in the vector table), from
+# the build's -fstack-usage (.su) and -fcyclomatic-complexity (.cyclo) files and the call
+# graph read out of the ELF, so _Min_Stack_Size can be sized from data rather than guessed.
+#
+# How it works:
+#   - Function frames come from the .su files, call edges from decoding every BL (and branches
+#     that leave a function, i.e. tail calls) in the ELF's Thumb code, .RamFunc code included
+#   - Calls through function pointers can't be seen in the code, so the dispatch points this
+#     project has (scheduler tasks, the render callback, the pattern registry, HAL DMA callbacks)
+#     are resolved from the sources in INDIRECT below. Add more with --call caller=callee,...
+#   - An ISR can only be preempted by a strictly higher priority (lower number) one, so the
+#     worst case is main plus the deepest handler of each priority level, each with its
+#     exception frame. Priorities come from the HAL_NVIC_SetPriority() calls in Core/Src.
+#
+# Functions without a .su entry (the C library, libgcc, startup assembly) count as 0 bytes and
+# are listed, as are recursion, dynamic frames and unresolved indirect calls.
+#
+# Usage: python3 Tools/stack_report.py [--elf Debug/Light-Array-9.elf] [--build Debug]
+# Exits with 1 if the worst case doesn't fit in _Min_Stack_Size.
+
+import argparse
+import glob
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCES = os.path.join(ROOT, "Core", "Src")
+LINKER = os.path.join(ROOT, "STM32C011J4MX_FLASH.ld")
+HAL_CONF = os.path.join(ROOT, "Core", "Inc", "stm32c0xx_hal_conf.h")
+
+EXCEPTION_FRAME = 8 * 4 + 4   # Stacked registers, plus the padding word when the stack isn't 8 byte aligned
+
+# Callees of each indirect call site: a regex run over Core/Src (group 1 is the callee), or a list of names
+INDIRECT = {
+	"scheduler_run":        r"scheduler_add_task\(\s*(\w+)",
+	"frame_scheduler_poll": r"frame_scheduler_init\(\s*\w+\s*,\s*(\w+)",
+	"pattern_select":       r"^\s*\{\s*\"[^\"]*\",\s*(\w+),",
+	"pattern_step":         r"^\s*\{\s*\"[^\"]*\",\s*\w+,\s*(\w+)",
+	"HAL_DMA_IRQHandler":   ["ADC_DMAConvCplt", "ADC_DMAHalfConvCplt", "ADC_DMAError"],
+}
+
+# Fixed priority core exceptions; SysTick is read from TICK_INT_PRIORITY
+CORE_PRIORITIES = {"NMI_Handler": -2, "HardFault_Handler": -1, "SVC_Handler": 0, "PendSV_Handler": 0}
+
+
+class Elf:
+	# Just enough of an ELF32 little endian reader for sections and symbols
+
+	def __init__(self, path):
+		with open(path, "rb") as f:
+			self.data = f.read()
+		if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+			raise ValueError("%s is not a 32-bit little endian ELF" % path)
+		shoff, = struct.unpack_from("<I", self.data, 0x20)
+		shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+		self.sections = []
+		for i in range(shnum):
+			fields = struct.unpack_from("<10I", self.data, shoff + i * shentsize)
+			self.sections.append(dict(zip(("name", "type", "flags", "addr", "offset", "size",
+										   "link", "info", "align", "entsize"), fields)))
+		names = self.sections[shstrndx]
+		for section in self.sections:
+			section["name"] = self.string(names, section["name"])
+
+	def string(self, table, offset):
+		start = table["offset"] + offset
+		return self.data[start:self.data.index(b"\0", start)].decode()
+
+	def section(self, name):
+		return next((s for s in self.sections if s["name"] == name), None)
+
+	def symbols(self):
+		# Yields (name, value, size, type)
+		for table in self.sections:
+			if table["type"] != 2:   # SHT_SYMTAB
+				continue
+			strings = self.sections[table["link"]]
+			for offset in range(table["offset"], table["offset"] + table["size"], 16):
+				name, value, size, info, _, _ = struct.unpack_from("<IIIBBH", self.data, offset)
+				if name:
+					yield self.string(strings, name), value, size, info & 0x0F
+
+	def read(self, addr, length):
+		# Reads from the section holding addr (by run address, so .RamFunc code works too)
+		for s in self.sections:
+			if s["type"] == 1 and s["flags"] & 0x2 and s["addr"] <= addr and addr + length <= s["addr"] + s["size"]:
+				start = s["offset"] + addr - s["addr"]
+				return self.data[start:start + length]
+		return None
+
+
+def sign_extend(value, bits):
+	return value - (1 << bits) if value & (1 << (bits - 1)) else value
+
+
+def branch_targets(code, base):
+	# Yields (target, is_indirect) for each BL, BLX register and branch in Thumb code at base
+	i = 0
+	while i + 2 <= len(code):
+		hw1, = struct.unpack_from("<H", code, i)
+		pc = base + i
+		if (hw1 & 0xF800) == 0xF000 and i + 4 <= len(code):
+			hw2, = struct.unpack_from("<H", code, i + 2)
+			if (hw2 & 0xD000) == 0xD000:   # BL
+				s = (hw1 >> 10) & 1
+				i1 = 1 - (((hw2 >> 13) & 1) ^ s)
+				i2 = 1 - (((hw2 >> 11) & 1) ^ s)
+				offset = (s << 24) | (i1 << 23) | (i2 << 22) | ((hw1 & 0x3FF) << 12) | ((hw2 & 0x7FF) << 1)
+				yield pc + 4 + sign_extend(offset, 25), False
+				i += 4
+				continue
+		if (hw1 & 0xFF87) == 0x4780:     # BLX register
+			yield None, True
+		elif (hw1 & 0xF800) == 0xE000:   # B
+			yield pc + 4 + sign_extend((hw1 & 0x7FF) << 1, 12), False
+		elif (hw1 & 0xF000) == 0xD000 and (hw1 & 0x0F00) < 0x0E00:   # B<cond>
+			yield pc + 4 + sign_extend((hw1 & 0xFF) << 1, 9), False
+		i += 2
+
+
+def base_name(name):
+	# GCC clones (foo.constprop.0, foo.part.0, ...) share the .su entry of foo
+	return name.split(".")[0]
+
+
+def read_per_function(pattern):
+	# Reads .su/.cyclo lines ("file:line:col:function<TAB>value[<TAB>qualifiers]")
+	values = {}
+	for path in glob.glob(pattern, recursive=True):
+		with open(path) as f:
+			for line in f:
+				fields = line.rstrip("\n").split("\t")
+				if len(fields) < 2:
+					continue
+				name = fields[0].rsplit(":", 1)[-1]
+				qualifier = fields[2] if len(fields) > 2 else ""
+				value = int(fields[1])
+				if name not in values or value > values[name][0]:
+					values[name] = (value, qualifier)
+	return values
+
+
+def read_sources():
+	text = ""
+	for path in sorted(glob.glob(os.path.join(SOURCES, "*.c"))):
+		with open(path) as f:
+			text += f.read() + "\n"
+	return text
+
+
+def read_priorities(sources):
+	priorities = dict(CORE_PRIORITIES)
+	for irq, priority in re.findall(r"HAL_NVIC_SetPriority\(\s*(\w+)_IRQn\s*,\s*(\d+)", sources):
+		priorities[irq + "_IRQHandler"] = int(priority)
+	with open(HAL_CONF) as f:
+		match = re.search(r"#define\s+TICK_INT_PRIORITY\s+(\d+)", f.read())
+	if match:
+		priorities["SysTick_Handler"] = int(match.group(1))
+	return priorities
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Worst-case stack depth per entry point")
+	parser.add_argument("--elf", default=os.path.join(ROOT, "Debug", "Light-Array-9.elf"))
+	parser.add_argument("--build", default=os.path.join(ROOT, "Debug"), help="directory holding the .su and .cyclo files")
+	parser.add_argument("--call", action="append", default=[], help="extra indirect calls, caller=callee[,callee]")
+	parser.add_argument("--margin", type=int, default=64, help="bytes of headroom in the suggested _Min_Stack_Size")
+	args = parser.parse_args()
+
+	elf = Elf(args.elf)
+	frames = read_per_function(os.path.join(args.build, "**", "*.su"))
+	cyclo = read_per_function(os.path.join(args.build, "**", "*.cyclo"))
+	sources = read_sources()
+	priorities = read_priorities(sources)
+
+	# Functions by start address; linker veneers to .RamFunc code stand in for their target
+	functions = {}
+	veneers = {}
+	default_handler = None
+	for name, value, size, kind in elf.symbols():
+		if kind == 2 and size:   # STT_FUNC
+			functions.setdefault(value & ~1, (name, size))
+		if name.startswith("__") and name.endswith("_veneer"):
+			veneers[value & ~1] = name[2:-len("_veneer")]
+		if name == "Default_Handler":
+			default_handler = value & ~1
+	by_name = {name: addr for addr, (name, _) in functions.items()}
+
+	calls = {}
+	indirect = set()
+	for addr, (name, size) in functions.items():
+		code = elf.read(addr, size) or b""
+		callees = calls.setdefault(name, set())
+		for target, is_indirect in branch_targets(code, addr):
+			if is_indirect:
+				indirect.add(name)
+			elif target in veneers:
+				callees.add(veneers[target])
+			elif target in functions and not addr <= target < addr + size:
+				callees.add(functions[target][0])
+
+	# Resolve function pointer calls
+	extra = dict(INDIRECT)
+	for entry in args.call:
+		caller, _, callees = entry.partition("=")
+		extra[caller] = callees.split(",")
+	for caller, callees in extra.items():
+		if caller not in calls:
+			continue
+		if isinstance(callees, str):
+			callees = re.findall(callees, sources, re.M)
+		calls[caller].update(c for c in callees if c in by_name)
+		indirect.discard(caller)
+
+	unknown = set()
+	dynamic = set()
+	recursive = set()
+	depths = {}
+
+	def frame(name):
+		entry = frames.get(name) or frames.get(base_name(name))
+		if entry is None:
+			unknown.add(name)
+			return 0
+		if "dynamic" in entry[1]:
+			dynamic.add(name)
+		return entry[0]
+
+	def depth(name, active):
+		# Returns (bytes, path) for the deepest call chain starting at name
+		if name in depths:
+			return depths[name]
+		if name in active:
+			recursive.add(name)
+			return 0, []
+		active.add(name)
+		deepest = (0, [])
+		for callee in sorted(calls.get(name, ())):
+			result = depth(callee, active)
+			if result[0] > deepest[0]:
+				deepest = result
+		active.discard(name)
+		own = frame(name)
+		depths[name] = (own + deepest[0], [name] + deepest[1])
+		return depths[name]
+
+	# Entry points: main and each handler the vector table actually points at
+	vectors = elf.section(".isr_vector")
+	handlers = []
+	for offset in range(4, vectors["size"], 4):
+		addr, = struct.unpack_from("<I", elf.data, vectors["offset"] + offset)
+		addr &= ~1
+		if addr and addr != default_handler and addr in functions:
+			name = functions[addr][0]
+			if name != "Reset_Handler" and name not in handlers:
+				handlers.append(name)
+
+	print("%-28s %5s %6s  %s" % ("entry point", "prio", "bytes", "deepest path (frame bytes, cyclomatic complexity)"))
+	main_depth, path = depth("main", set())
+	rows = [("main", None, main_depth, path)]
+	for name in handlers:
+		bytes_used, path = depth(name, set())
+		rows.append((name, priorities.get(name), bytes_used, path))
+	for name, priority, bytes_used, path in rows:
+		steps = ["%s(%d,%s)" % (f, frame(f), cyclo.get(f, cyclo.get(base_name(f), ("?",)))[0]) for f in path]
+		print("%-28s %5s %6d  %s" % (name, "-" if priority is None else priority, bytes_used, " > ".join(steps)))
+
+	# One handler per priority level can be stacked on main at a time; unknown priorities get a level each
+	levels = {}
+	for name, priority, bytes_used, _ in rows[1:]:
+		key = priority if priority is not None else "?" + name
+		if bytes_used + EXCEPTION_FRAME > levels.get(key, (0, None))[0]:
+			levels[key] = (bytes_used + EXCEPTION_FRAME, name)
+	total = main_depth + sum(bytes_used for bytes_used, _ in levels.values())
+
+	with open(LINKER) as f:
+		stack_size = int(re.search(r"_Min_Stack_Size\s*=\s*(0x[0-9A-Fa-f]+|\d+)", f.read()).group(1), 0)
+
+	print()
+	print("Worst case: main %d" % main_depth, end="")
+	for key in sorted(levels, key=lambda k: (isinstance(k, str), k if isinstance(k, int) else 0, str(k))):
+		print(" + %s %d" % (levels[key][1], levels[key][0]), end="")
+	print(" = %d bytes (exception frames of %d included)" % (total, EXCEPTION_FRAME))
+	suggested = (total + args.margin + 7) & ~7
+	print("_Min_Stack_Size is %d (0x%X), %d bytes spare; %d (0x%X) would leave %d bytes of margin" %
+		  (stack_size, stack_size, stack_size - total, suggested, suggested, args.margin))
+
+	notes = (("No .su entry (counted as 0 bytes)", unknown),
+			 ("Dynamic stack frames", dynamic),
+			 ("Recursion (one pass counted)", recursive),
+			 ("Unresolved indirect calls, add with --call", indirect & set(depths)))
+	for title, names in notes:
+		if names:
+			print()
+			print("%s:" % title)
+			print("  " + " ".join(sorted(names)))
+
+	return 0 if total <= stack_size else 1
+
+
+if __name__ == "__main__":
+	sys.exit(main())